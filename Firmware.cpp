@@ -0,0 +1,198 @@
+#include <cassert>
+
+#include <q/support/literals.hpp>
+#include <q/fx/biquad.hpp>
+
+#include <Firmware.h>
+#include <util/Denormals.h>
+#include <util/EffectState.h>
+#include <util/LoadShedder.h>
+#include <util/Multirate.h>
+#include <util/OctaveGenerator.h>
+
+namespace q = cycfi::q;
+using namespace q::literals;
+
+Terrarium* terrarium = nullptr;
+OctaveGenerator* octave = nullptr;
+EffectState interface_state;
+bool enable_effect = false;
+
+// New band layouts are computed in the control loop, this many bands per
+// iteration, so that a layout change never adds load to the audio callback.
+constexpr int layout_bands_per_loop = 10;
+
+// The DFT filter bank spaces its bands uniformly, so it needs more of them
+// to resolve low notes, but each costs much less. It maps a layout of 160
+// bands over the default range to 105 bands 15.6 Hz apart (107 with the
+// bass toggle), and the economy layout to 53 bands 31.2 Hz apart.
+#if defined(DFT_FILTER_BANK)
+constexpr int band_count = 160;
+constexpr int economy_band_count = 80;
+#else
+constexpr int band_count = 80;
+constexpr int economy_band_count = 48;
+#endif
+
+// When the audio callback gets close to its deadline, the highest bands are
+// skipped, this many per shed level.
+constexpr int bands_per_shed_level = 4;
+LoadShedder load_shedder;
+
+//=============================================================================
+// Voices quieter than this (-60 dB) are not computed at all.
+constexpr float voice_threshold = 0.001f;
+
+unsigned activeVoices(const EffectState& s)
+{
+    unsigned voices = 0;
+    if (s.up1Level() > voice_threshold)
+    {
+        voices |= voice::up1;
+    }
+    if (s.down1Level() > voice_threshold)
+    {
+        voices |= voice::down1;
+    }
+    if (s.down2Level() > voice_threshold)
+    {
+        voices |= voice::down2;
+    }
+    if (s.up2Level() > voice_threshold)
+    {
+        voices |= voice::up2;
+    }
+    if (s.down3Level() > voice_threshold)
+    {
+        voices |= voice::down3;
+    }
+    return voices;
+}
+
+//=============================================================================
+void processAudioBlock(
+    Terrarium::InputBuffer in,
+    Terrarium::OutputBuffer out,
+    size_t size)
+{
+    static const auto sample_rate = terrarium->AudioSampleRate();
+    static const auto tick_rate = terrarium->TimerTickRate();
+    const auto start_ticks = terrarium->TimerTicks();
+
+    static Decimator decimate;
+    static Interpolator interpolate;
+    static q::highshelf eq1(-11, 140_Hz, sample_rate);
+    static q::lowshelf eq2(5, 160_Hz, sample_rate);
+
+    const auto& s = interface_state;
+
+    octave->applyLayout();
+    octave->setShedBands(load_shedder.level() * bands_per_shed_level);
+
+    // The wet signal is discarded while bypassed
+    octave->setVoices(enable_effect ? activeVoices(s) : 0);
+
+    for (size_t i = 0; i <= (size - resample_factor); i += resample_factor)
+    {
+        std::span<const float, resample_factor> in_chunk(
+            &(in[0][i]), resample_factor);
+        const auto sample = decimate(in_chunk);
+
+        float octave_mix = 0;
+        octave->update(sample);
+        octave_mix += s.up1Level() * octave->up1();
+        octave_mix += s.down1Level() * octave->down1();
+        octave_mix += s.down2Level() * octave->down2();
+        octave_mix += s.up2Level() * octave->up2();
+        octave_mix += s.down3Level() * octave->down3();
+
+        auto out_chunk = interpolate(octave_mix);
+        for (size_t j = 0; j < out_chunk.size(); ++j)
+        {
+            float mix = eq2(eq1(out_chunk[j]));
+
+            const auto dry_signal = in[0][i+j];
+            mix += s.dryLevel() * dry_signal;
+
+            out[0][i+j] = enable_effect ? mix : dry_signal;
+            out[1][i+j] = 0;
+        }
+    }
+
+    const auto elapsed = terrarium->TimerTicks() - start_ticks;
+    load_shedder.update(elapsed / (tick_rate * size / sample_rate));
+}
+
+const LoadShedder& loadShedder()
+{
+    return load_shedder;
+}
+
+//=============================================================================
+void runFirmware(Terrarium& hardware)
+{
+    terrarium = &hardware;
+
+    hardware.Init(true);
+    // These settings are expected by Decimator/Interpolator
+    assert(hardware.AudioSampleRate() == 48000);
+    assert(hardware.AudioBlockSize() % resample_factor == 0);
+
+    BandLayout band_layout;
+    band_layout.band_count = band_count;
+
+    static OctaveGenerator octave_generator(
+        hardware.AudioSampleRate() / resample_factor, band_layout);
+    octave = &octave_generator;
+
+    constexpr int knob_dry = 0;
+    constexpr int knob_down3 = 1;
+    constexpr int knob_up2 = 2;
+    constexpr int knob_down2 = 3;
+    constexpr int knob_down1 = 4;
+    constexpr int knob_up1 = 5;
+
+    constexpr int toggle_bass = 0;
+    constexpr int toggle_economy = 1;
+
+    constexpr int stomp_bypass = 0;
+
+    constexpr int led_enable = 0;
+
+
+    enableFlushToZero();
+    hardware.StartAudio(processAudioBlock);
+
+    hardware.Loop(100, [&](){
+        interface_state.setDryRatio(hardware.ProcessKnob(knob_dry));
+        interface_state.setUp1Ratio(hardware.ProcessKnob(knob_up1));
+        interface_state.setDown1Ratio(hardware.ProcessKnob(knob_down1));
+        interface_state.setDown2Ratio(hardware.ProcessKnob(knob_down2));
+        interface_state.setUp2Ratio(hardware.ProcessKnob(knob_up2));
+        interface_state.setDown3Ratio(hardware.ProcessKnob(knob_down3));
+
+        BandLayout layout;
+        layout.band_count = band_count;
+        if (hardware.ToggleOn(toggle_bass))
+        {
+            layout.min_freq = 30;
+        }
+        if (hardware.ToggleOn(toggle_economy))
+        {
+            layout.band_count = economy_band_count;
+        }
+        if (layout != band_layout)
+        {
+            band_layout = layout;
+            octave->setLayout(layout);
+        }
+        octave->prepareLayout(layout_bands_per_loop);
+
+        if (hardware.StompRisingEdge(stomp_bypass))
+        {
+            enable_effect = !enable_effect;
+        }
+
+        hardware.SetLed(led_enable, enable_effect ? 1 : 0);
+    });
+}
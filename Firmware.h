@@ -0,0 +1,12 @@
+#pragma once
+
+#include <util/LoadShedder.h>
+#include <util/Terrarium.h>
+
+// Initializes the given hardware, starts audio processing and runs the
+// control loop. Never returns on the device; simulated hardware returns once
+// its input is exhausted.
+void runFirmware(Terrarium& hardware);
+
+// Load shedding state and statistics of the audio callback
+const LoadShedder& loadShedder();
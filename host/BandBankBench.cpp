@@ -0,0 +1,209 @@
+// Compares the band banks of the octave generator, the recursive bank of
+// independent band filters and the polyphase DFT filter bank, at 80, 160 and
+// 320 bands. The recursive bank covers the default frequency range. The DFT
+// bank spaces its bands uniformly at a power of two fraction of the sample
+// rate, so it gets the finest such spacing that is not coarser than the mean
+// spacing of the recursive bank, from the same lowest frequency, which ends
+// its range a little lower.
+//
+//   bands       number of bands the bank actually has
+//   spacing     band spacing in Hz at the low and high end of the range
+//   ns/sample   cost per 8 kHz sample of the bank alone, i.e. of the band
+//               analysis with all voices disabled, and the added cost of
+//               computing up1, down1 and down2
+//   latency     time from the onset of a tone burst until up1 and down1
+//               reach half of their steady RMS, for E2 and A3
+//   spur        energy of up1 and down1 not at the expected frequency,
+//               relative to the energy that is, for a steady A3
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <numbers>
+#include <vector>
+
+#include <util/Multirate.h>
+#include <util/OctaveGenerator.h>
+
+constexpr float sample_rate = 48000 / resample_factor;
+constexpr auto pi = std::numbers::pi;
+
+std::vector<float> sine(double freq, size_t size, size_t onset = 0)
+{
+    std::vector<float> x(size, 0.0f);
+    for (size_t n = onset; n < size; ++n)
+    {
+        x[n] = float(0.5 * std::sin(2 * pi * freq * (n - onset) / sample_rate));
+    }
+    return x;
+}
+
+template <typename Generator>
+std::vector<float> run(Generator& octave, const std::vector<float>& x,
+                       unsigned v)
+{
+    octave.setVoices(v);
+    std::vector<float> y;
+    for (auto sample : x)
+    {
+        octave.update(sample);
+        y.push_back((v == voice::up1) ? octave.up1() : octave.down1());
+    }
+    return y;
+}
+
+double ratio(unsigned v)
+{
+    return (v == voice::up1) ? 2.0 : 0.5;
+}
+
+// Energy of x not explained by a sine and cosine at freq, relative to the
+// energy that is, in dB
+double spurLevel(const std::vector<float>& x, double freq)
+{
+    double ss = 0, sc = 0, cc = 0, xs = 0, xc = 0;
+    for (size_t n = 0; n < x.size(); ++n)
+    {
+        const auto s = std::sin(2 * pi * freq * n / sample_rate);
+        const auto c = std::cos(2 * pi * freq * n / sample_rate);
+        ss += s * s;
+        sc += s * c;
+        cc += c * c;
+        xs += x[n] * s;
+        xc += x[n] * c;
+    }
+    const auto det = ss * cc - sc * sc;
+    const auto a = (xs * cc - xc * sc) / det;
+    const auto b = (xc * ss - xs * sc) / det;
+
+    double fit_energy = 0;
+    double residual_energy = 0;
+    for (size_t n = 0; n < x.size(); ++n)
+    {
+        const auto fit = a * std::sin(2 * pi * freq * n / sample_rate) +
+                         b * std::cos(2 * pi * freq * n / sample_rate);
+        fit_energy += fit * fit;
+        residual_energy += (x[n] - fit) * (x[n] - fit);
+    }
+    return 10 * std::log10(residual_energy / fit_energy);
+}
+
+template <typename Generator>
+double latencyMs(const BandLayout& layout, double freq, unsigned v)
+{
+    const size_t onset = size_t(sample_rate / 4);
+    Generator octave(sample_rate, layout);
+    const auto y = run(octave, sine(freq, size_t(sample_rate), onset), v);
+
+    // RMS over two periods of the shifted tone, centered on n
+    const auto half = size_t(sample_rate / (freq * ratio(v)));
+    const auto rms = [&](size_t n){
+        double sum = 0;
+        for (size_t k = n - half; k < n + half; ++k)
+        {
+            sum += double(y[k]) * y[k];
+        }
+        return std::sqrt(sum / (2 * half));
+    };
+
+    const auto steady = rms(y.size() - half - 1);
+    for (size_t n = onset; n + half < y.size(); ++n)
+    {
+        if (rms(n) >= 0.5 * steady)
+        {
+            return (n - onset) * 1000 / sample_rate;
+        }
+    }
+    return 1000;
+}
+
+template <typename Generator>
+double nsPerSample(const BandLayout& layout, unsigned voices)
+{
+    using clock = std::chrono::steady_clock;
+
+    Generator octave(sample_rate, layout);
+    const auto x = sine(220, size_t(sample_rate) * 2);
+    octave.setVoices(voices);
+    float sink = 0;
+    const auto begin = clock::now();
+    for (auto sample : x)
+    {
+        octave.update(sample);
+        sink += octave.up1() + octave.down1() + octave.down2();
+    }
+    const auto end = clock::now();
+    volatile float keep = sink;
+    (void)keep;
+    return std::chrono::duration<double, std::nano>(
+        end - begin).count() / x.size();
+}
+
+template <typename Generator>
+void report(const char* name, const BandLayout& layout)
+{
+    const auto bank_ns = nsPerSample<Generator>(layout, 0);
+    const auto voices_ns = nsPerSample<Generator>(
+        layout, voice::up1 | voice::down1 | voice::down2) - bank_ns;
+    Generator octave(sample_rate, layout);
+
+    const auto& centers = octave.centers();
+    const auto low_spacing = centers[1] - centers[0];
+    const auto high_spacing = centers.back() - centers[centers.size() - 2];
+
+    double latency_e2 = 0;
+    double latency_a3 = 0;
+    double spur = -1000;
+    for (auto v : {voice::up1, voice::down1})
+    {
+        latency_e2 = std::max(latency_e2,
+            latencyMs<Generator>(layout, 82.41, v));
+        latency_a3 = std::max(latency_a3,
+            latencyMs<Generator>(layout, 220, v));
+
+        Generator steady(sample_rate, layout);
+        auto y = run(steady, sine(220, size_t(sample_rate)), v);
+        y.erase(y.begin(), y.begin() + y.size() / 2);
+        spur = std::max(spur, spurLevel(y, 220 * ratio(v)));
+    }
+
+    std::printf("%5zu %-10s %6.1f %6.1f %8.1f %8.1f %8.1f %8.1f %8.1f\n",
+        centers.size(), name, low_spacing, high_spacing, bank_ns,
+        voices_ns, latency_e2, latency_a3, spur);
+}
+
+// Layout with the given number of DFT bands; see the top of the file
+BandLayout dftLayout(int bands)
+{
+    BandLayout layout;
+    layout.band_count = bands;
+
+    const auto mean_spacing =
+        (layout.max_freq - layout.min_freq) / (bands - 1);
+    auto spacing = sample_rate;
+    while (spacing > mean_spacing)
+    {
+        spacing /= 2;
+    }
+    layout.max_freq = layout.min_freq + (bands - 1) * spacing;
+    return layout;
+}
+
+int main()
+{
+    using Recursive = BasicOctaveGenerator<RecursiveBank<float, FastRoots>>;
+    using Dft = BasicOctaveGenerator<DftBank<float, FastRoots>>;
+
+    std::printf("%5s %-10s %13s %17s %17s %8s\n", "", "",
+        "spacing (Hz)", "ns/sample", "latency (ms)", "");
+    std::printf("%5s %-10s %6s %6s %8s %8s %8s %8s %8s\n", "bands", "bank",
+        "low", "high", "bank", "voices", "E2", "A3", "spur dB");
+    for (int bands : {80, 160, 320})
+    {
+        BandLayout layout;
+        layout.band_count = bands;
+        report<Recursive>("recursive", layout);
+        report<Dft>("dft", dftLayout(bands));
+    }
+}
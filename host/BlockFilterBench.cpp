@@ -0,0 +1,237 @@
+// Checks the block state-space form of the band filters (BlockBandFilter)
+// against the per-sample recursion of BandShifter, and compares their cost.
+//
+// For each block size and precision, every band of the default layout is run
+// both ways on the same input. The error energy of the up1, down1 and down2
+// voices over all bands is reported relative to the recursion in double
+// precision, both for the recursion and for the block form in the precision
+// under test, so the precision lost by the block form can be read directly.
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <complex>
+#include <cstdio>
+#include <numbers>
+#include <random>
+#include <vector>
+
+#include <util/BandFilter.h>
+#include <util/BandShifter.h>
+#include <util/OctaveGenerator.h>
+
+constexpr float sample_rate = 8000;
+constexpr size_t sample_count = 5 * 8000;
+
+std::vector<float> testSignal()
+{
+    constexpr auto pi = std::numbers::pi;
+    std::minstd_rand rng(1);
+    std::normal_distribution<double> noise(0, 0.01);
+
+    std::vector<float> x(sample_count);
+    for (size_t n = 0; n < x.size(); ++n)
+    {
+        double v = noise(rng);
+        for (double f : {110.0, 164.81, 220.0, 987.77})
+        {
+            v += 0.2 * std::sin(2 * pi * f * n / sample_rate);
+        }
+        x[n] = float(v);
+    }
+    return x;
+}
+
+// Voice outputs of one band
+struct Trace
+{
+    std::vector<double> up1;
+    std::vector<double> down1;
+    std::vector<double> down2;
+
+    void add(double u1, double d1, double d2)
+    {
+        up1.push_back(u1);
+        down1.push_back(d1);
+        down2.push_back(d2);
+    }
+};
+
+template <typename T>
+Trace recursion(const std::vector<float>& x, float center, float bw)
+{
+    BasicBandShifter<T, ExactRoots> shifter(center, sample_rate, bw);
+    Trace trace;
+    for (auto sample : x)
+    {
+        shifter.update(sample, voice::up1 | voice::from_down2);
+        trace.add(shifter.up1(), shifter.down1(), shifter.down2());
+    }
+    return trace;
+}
+
+template <typename T, size_t K>
+Trace block(const std::vector<float>& x, float center, float bw)
+{
+    BasicBandShifter<T, ExactRoots> shifter(center, sample_rate, bw);
+    const BlockBandFilter<T, K> filter(
+        BandFilterCoefficients(center, sample_rate, bw));
+
+    Trace trace;
+    std::array<T, K> samples;
+    for (size_t n = 0; n + K <= x.size(); n += K)
+    {
+        std::copy_n(x.begin() + n, K, samples.begin());
+        shifter.updateBlock(filter, std::span<const T, K>(samples),
+            voice::up1 | voice::from_down2, [&](size_t){
+                trace.add(shifter.up1(), shifter.down1(), shifter.down2());
+            });
+    }
+    return trace;
+}
+
+// Accumulates error energy against a reference over all bands
+struct Errors
+{
+    struct Energy
+    {
+        double signal = 0;
+        double error = 0;
+
+        void add(const std::vector<double>& y, const std::vector<double>& ref)
+        {
+            for (size_t n = 0; n < y.size(); ++n)
+            {
+                signal += ref[n] * ref[n];
+                error += (y[n] - ref[n]) * (y[n] - ref[n]);
+            }
+        }
+
+        // Error level in dB relative to the reference
+        double db() const
+        {
+            return 10 * std::log10(error / signal);
+        }
+    };
+
+    Energy up1;
+    Energy down1;
+    Energy down2;
+
+    void add(const Trace& t, const Trace& ref)
+    {
+        up1.add(t.up1, ref.up1);
+        down1.add(t.down1, ref.down1);
+        down2.add(t.down2, ref.down2);
+    }
+};
+
+// ns per band and sample of running all bands with the given voices
+template <typename T, size_t K, bool use_block>
+double cost(const std::vector<float>& x, const BandLayout& layout,
+            unsigned voices)
+{
+    using Shifter = BasicBandShifter<T, FastRoots>;
+    std::vector<Shifter> shifters;
+    std::vector<BlockBandFilter<T, K>> filters;
+    for (int i = 0; i < layout.band_count; ++i)
+    {
+        const auto center = layout.centerFreq(i);
+        const auto bw = layout.bandwidth(i);
+        shifters.emplace_back(center, sample_rate, bw);
+        filters.emplace_back(BandFilterCoefficients(center, sample_rate, bw));
+    }
+
+    using clock = std::chrono::steady_clock;
+    std::array<T, K> samples;
+    T sink = 0;
+    const auto begin = clock::now();
+    for (size_t n = 0; n + K <= x.size(); n += K)
+    {
+        std::copy_n(x.begin() + n, K, samples.begin());
+        for (size_t i = 0; i < shifters.size(); ++i)
+        {
+            auto& shifter = shifters[i];
+            if constexpr (use_block)
+            {
+                shifter.updateBlock(filters[i],
+                    std::span<const T, K>(samples), voices,
+                    [&](size_t){ sink += shifter.up1(); });
+            }
+            else
+            {
+                for (auto sample : samples)
+                {
+                    shifter.update(sample, voices);
+                    sink += shifter.up1();
+                }
+            }
+        }
+    }
+    const auto end = clock::now();
+
+    volatile T keep = sink;
+    (void)keep;
+    return std::chrono::duration<double, std::nano>(end - begin).count() /
+        (double(x.size()) * shifters.size());
+}
+
+template <typename T, size_t K>
+void report(const char* precision, const std::vector<float>& x)
+{
+    const BandLayout layout;
+    Errors recursion_errors;
+    Errors block_errors;
+    for (int i = 0; i < layout.band_count; ++i)
+    {
+        const auto center = layout.centerFreq(i);
+        const auto bw = layout.bandwidth(i);
+        auto ref = recursion<double>(x, center, bw);
+        const auto rec = recursion<T>(x, center, bw);
+        const auto blk = block<T, K>(x, center, bw);
+
+        recursion_errors.add(rec, ref);
+        block_errors.add(blk, ref);
+    }
+
+    std::printf("K = %zu, %s\n", K, precision);
+    std::printf("  error vs double recursion (dB): %8s %8s %8s\n",
+        "up1", "down1", "down2");
+    std::printf("    recursion %21s %8.1f %8.1f %8.1f\n", "",
+        recursion_errors.up1.db(), recursion_errors.down1.db(),
+        recursion_errors.down2.db());
+    std::printf("    block     %21s %8.1f %8.1f %8.1f\n", "",
+        block_errors.up1.db(), block_errors.down1.db(),
+        block_errors.down2.db());
+
+    // With few bands there is little independent work besides the serial
+    // recursion of each band
+    BandLayout few_bands;
+    few_bands.band_count = 4;
+
+    const auto filter_only = 0u;
+    const auto voices = voice::up1 | voice::down1 | voice::down2;
+    std::printf("  cost (ns per band and sample, recursion -> block):\n");
+    std::printf("    %2d bands: filter only %6.2f -> %6.2f, "
+                "with voices %6.2f -> %6.2f\n", layout.band_count,
+        cost<T, K, false>(x, layout, filter_only),
+        cost<T, K, true>(x, layout, filter_only),
+        cost<T, K, false>(x, layout, voices),
+        cost<T, K, true>(x, layout, voices));
+    std::printf("    %2d bands: filter only %6.2f -> %6.2f, "
+                "with voices %6.2f -> %6.2f\n", few_bands.band_count,
+        cost<T, K, false>(x, few_bands, filter_only),
+        cost<T, K, true>(x, few_bands, filter_only),
+        cost<T, K, false>(x, few_bands, voices),
+        cost<T, K, true>(x, few_bands, voices));
+}
+
+int main()
+{
+    const auto x = testSignal();
+    report<float, 4>("float", x);
+    report<float, 8>("float", x);
+    report<double, 4>("double", x);
+    report<double, 8>("double", x);
+}
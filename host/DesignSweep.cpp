@@ -0,0 +1,506 @@
+// Sweeps the design space of the signal chain and reports which designs are
+// worth considering: for every combination of band count, resampler engine,
+// square root implementation and arithmetic precision it measures
+//
+//   ns_per_sample  cost of the chain per 48 kHz sample (up1, down1, down2)
+//   snr_db         agreement of up1 and down1 at the 48 kHz output with
+//                  the reference design: the largest band count, the FIR
+//                  resampler, exact square roots and double precision.
+//                  This measures how close a design comes to the reference,
+//                  not how accurately either tracks the input.
+//                  The output is aligned to the reference and scaled by
+//                  the least-squares gain first, so differences in delay
+//                  and level are not counted (worst case over the single
+//                  notes). The chord is left out: the phase of each band
+//                  differs between designs, so no single alignment fits all
+//                  of its tones. The reference design itself is not
+//                  measured and reports inf.
+//   spur_db        energy at the 48 kHz output that is not at the expected
+//                  shifted frequencies, relative to the energy that is
+//                  (worst case over the test signals)
+//   group_delay_ms delay of the energy centroid of the output behind the
+//                  one of a Hann-windowed tone burst (worst of up1 and
+//                  down1 for E2, A3 and A4)
+//
+// All rows are written as CSV, and the Pareto-optimal rows, i.e. the ones
+// no other row matches or beats on every metric, are printed. Differences
+// below the measurement resolution (see tolerance) count as a match. The
+// reference design is left out, as its SNR is not measured; it is printed
+// separately.
+//
+// Usage: DesignSweep [output.csv]
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <complex>
+#include <cstdio>
+#include <limits>
+#include <numbers>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include <util/BandShifter.h>
+#include <util/Fft.h>
+#include <util/Multirate.h>
+#include <util/OctaveGenerator.h>
+
+constexpr double sample_rate = 48000;
+constexpr double low_rate = sample_rate / resample_factor;
+constexpr auto pi = std::numbers::pi;
+
+constexpr std::array band_counts{32, 48, 64, 80, 120, 160};
+
+//=============================================================================
+// Test signals: single notes across the guitar range and an A power chord.
+struct TestSignal
+{
+    const char* name;
+    std::vector<double> freqs;
+};
+
+const std::vector<TestSignal> test_signals = {
+    {"E2", {82.41}},
+    {"A2", {110.0}},
+    {"E3", {164.81}},
+    {"A3", {220.0}},
+    {"A4", {440.0}},
+    {"B5", {987.77}},
+    {"A5 chord", {110.0, 164.81, 220.0}},
+};
+
+std::vector<float> render(const TestSignal& signal, double rate,
+                          size_t size, size_t onset = 0)
+{
+    std::vector<float> out(size, 0.0f);
+    const auto amplitude = 0.5 / signal.freqs.size();
+    for (size_t n = onset; n < size; ++n)
+    {
+        double x = 0;
+        for (auto f : signal.freqs)
+        {
+            x += std::sin(2 * pi * f * (n - onset) / rate);
+        }
+        out[n] = float(amplitude * x);
+    }
+    return out;
+}
+
+// Expected frequencies of a voice for the given input frequencies
+std::vector<double> shifted(const std::vector<double>& freqs, unsigned v)
+{
+    const auto ratio = (v == voice::up1) ? 2.0 : 0.5;
+    std::vector<double> out;
+    for (auto f : freqs)
+    {
+        out.push_back(f * ratio);
+    }
+    return out;
+}
+
+//=============================================================================
+// Energy of x not explained by a least-squares fit of sines and cosines at
+// the given frequencies, relative to the energy that is, in dB.
+double spurLevel(const std::vector<float>& x, const std::vector<double>& freqs,
+                 double rate)
+{
+    const auto m = 2 * freqs.size();
+    const auto basis = [&](size_t k, size_t n){
+        const auto w = 2 * pi * freqs[k / 2] * n / rate;
+        return (k % 2) ? std::cos(w) : std::sin(w);
+    };
+
+    // Normal equations [A | b]
+    std::vector<std::vector<double>> a(m, std::vector<double>(m + 1, 0.0));
+    for (size_t n = 0; n < x.size(); ++n)
+    {
+        for (size_t i = 0; i < m; ++i)
+        {
+            const auto bi = basis(i, n);
+            for (size_t j = 0; j < m; ++j)
+            {
+                a[i][j] += bi * basis(j, n);
+            }
+            a[i][m] += bi * x[n];
+        }
+    }
+
+    // Gaussian elimination with partial pivoting
+    for (size_t i = 0; i < m; ++i)
+    {
+        size_t pivot = i;
+        for (size_t r = i + 1; r < m; ++r)
+        {
+            if (std::abs(a[r][i]) > std::abs(a[pivot][i]))
+            {
+                pivot = r;
+            }
+        }
+        std::swap(a[i], a[pivot]);
+        for (size_t r = 0; r < m; ++r)
+        {
+            if (r != i)
+            {
+                const auto scale = a[r][i] / a[i][i];
+                for (size_t c = i; c <= m; ++c)
+                {
+                    a[r][c] -= scale * a[i][c];
+                }
+            }
+        }
+    }
+
+    double fit_energy = 0;
+    double residual_energy = 0;
+    for (size_t n = 0; n < x.size(); ++n)
+    {
+        double fit = 0;
+        for (size_t k = 0; k < m; ++k)
+        {
+            fit += a[k][m] / a[k][k] * basis(k, n);
+        }
+        fit_energy += fit * fit;
+        residual_energy += (x[n] - fit) * (x[n] - fit);
+    }
+    return 10 * std::log10(residual_energy / fit_energy);
+}
+
+// Lag in samples by which y trails r, at the largest magnitude of their
+// cross-correlation within +-max_lag
+long bestLag(const std::vector<float>& y, const std::vector<float>& r,
+             long max_lag)
+{
+    size_t size = 1;
+    while (size < 2 * std::max(y.size(), r.size()))
+    {
+        size *= 2;
+    }
+    std::vector<std::complex<double>> a(size), b(size);
+    std::copy(y.begin(), y.end(), a.begin());
+    std::copy(r.begin(), r.end(), b.begin());
+    Fft<double> forward(size);
+    Fft<double> inverse(size, 1);
+    forward(a);
+    forward(b);
+    for (size_t k = 0; k < size; ++k)
+    {
+        a[k] *= std::conj(b[k]);
+    }
+    // a[lag mod size] = sum_n y[n + lag] r[n]
+    inverse(a);
+
+    long best = 0;
+    for (long lag = -max_lag; lag <= max_lag; ++lag)
+    {
+        const auto index = size_t((lag + long(size)) % long(size));
+        const auto best_index = size_t((best + long(size)) % long(size));
+        if (std::abs(a[index].real()) > std::abs(a[best_index].real()))
+        {
+            best = lag;
+        }
+    }
+    return best;
+}
+
+// Energy of r scaled by the least-squares gain onto y, relative to the
+// energy of the remainder of y, in dB, with y shifted back by lag
+double alignedSnr(const std::vector<float>& y, const std::vector<float>& r,
+                  long lag)
+{
+    double yr = 0;
+    double yy = 0;
+    double rr = 0;
+    for (long n = std::max(0L, -lag);
+         n < long(r.size()) && n + lag < long(y.size()); ++n)
+    {
+        const double a = y[n + lag];
+        const double b = r[n];
+        yr += a * b;
+        yy += a * a;
+        rr += b * b;
+    }
+    const auto fit = yr * yr / rr;
+    return 10 * std::log10(fit / std::max(yy - fit, 0.0));
+}
+
+// Skips the start-up transient
+template <typename V>
+V settled(const V& x)
+{
+    return {x.begin() + x.size() / 2, x.end()};
+}
+
+const std::vector<float>& referenceOutput(size_t signal, unsigned v);
+
+//=============================================================================
+template <typename T, typename Roots, typename D, typename I>
+struct Design
+{
+    using Generator = BasicOctaveGenerator<RecursiveBank<T, Roots>>;
+
+    static BandLayout layout(int band_count)
+    {
+        BandLayout l;
+        l.band_count = band_count;
+        return l;
+    }
+
+    // The chain of processAudioBlock without the EQ and dry mix
+    static std::vector<float> process(const std::vector<float>& in,
+                                      int band_count, unsigned voices)
+    {
+        D decimate;
+        I interpolate;
+        Generator octave{float(low_rate), layout(band_count)};
+        octave.setVoices(voices);
+
+        std::vector<float> out(in.size(), 0.0f);
+        for (size_t i = 0; i + resample_factor <= in.size();
+             i += resample_factor)
+        {
+            std::span<const float, resample_factor> chunk(
+                &in[i], resample_factor);
+            octave.update(decimate(chunk));
+            const auto mix = float(octave.up1() + octave.down1() +
+                                   octave.down2());
+            const auto out_chunk = interpolate(mix);
+            std::copy(out_chunk.begin(), out_chunk.end(), out.begin() + i);
+        }
+        return out;
+    }
+
+    static double nsPerSample(int band_count)
+    {
+        using clock = std::chrono::steady_clock;
+        const auto in = render(test_signals.back(), sample_rate,
+                               size_t(sample_rate));
+        constexpr auto voices = voice::up1 | voice::down1 | voice::down2;
+
+        double best = 1e30;
+        for (int run = 0; run < 3; ++run)
+        {
+            const auto begin = clock::now();
+            const auto out = process(in, band_count, voices);
+            const auto end = clock::now();
+            volatile float sink = out.back();
+            (void)sink;
+            best = std::min(best, std::chrono::duration<double, std::nano>(
+                end - begin).count() / in.size());
+        }
+        return best;
+    }
+
+    static double snr(size_t signal, int band_count, unsigned v)
+    {
+        // Delays differ by up to a few tens of ms between designs
+        constexpr auto max_lag = long(0.05 * sample_rate);
+        const auto in = render(test_signals[signal], sample_rate,
+                               size_t(sample_rate));
+        const auto out = settled(process(in, band_count, v));
+        const auto& ref = referenceOutput(signal, v);
+        return alignedSnr(out, ref, bestLag(out, ref, max_lag));
+    }
+
+    static double spur(const TestSignal& signal, int band_count, unsigned v)
+    {
+        const auto in = render(signal, sample_rate, size_t(sample_rate));
+        const auto out = settled(process(in, band_count, v));
+        return spurLevel(out, shifted(signal.freqs, v), sample_rate);
+    }
+
+    static double groupDelayMs(double freq, int band_count, unsigned v)
+    {
+        const auto size = size_t(sample_rate);
+        const auto burst = size_t(0.2 * sample_rate);
+        const auto onset = size_t(0.1 * sample_rate);
+        auto in = render({"burst", {freq}}, sample_rate, size, onset);
+        for (size_t n = 0; n < size; ++n)
+        {
+            const auto t = double(n) - double(onset);
+            in[n] *= float((t < 0 || t > burst) ? 0.0 :
+                0.5 - 0.5 * std::cos(2 * pi * t / burst));
+        }
+        const auto out = process(in, band_count, v);
+
+        const auto centroid = [](const std::vector<float>& x){
+            double sum = 0;
+            double weighted = 0;
+            for (size_t n = 0; n < x.size(); ++n)
+            {
+                sum += double(x[n]) * x[n];
+                weighted += n * double(x[n]) * x[n];
+            }
+            return weighted / sum;
+        };
+        return (centroid(out) - centroid(in)) * 1000 / sample_rate;
+    }
+};
+
+// The reference design, at the largest band count
+using Reference = Design<double, ExactRoots, FirDecimator, FirInterpolator>;
+
+// Settled output of the reference design for a test signal and voice,
+// computed on first use
+const std::vector<float>& referenceOutput(size_t signal, unsigned v)
+{
+    static std::vector<std::vector<float>> cache(2 * test_signals.size());
+
+    auto& out = cache[2 * signal + ((v == voice::up1) ? 0 : 1)];
+    if (out.empty())
+    {
+        const auto in = render(test_signals[signal], sample_rate,
+                               size_t(sample_rate));
+        out = settled(Reference::process(in, band_counts.back(), v));
+    }
+    return out;
+}
+
+//=============================================================================
+struct Row
+{
+    int band_count = 0;
+    std::string resampler;
+    std::string roots;
+    std::string precision;
+    double ns_per_sample = 0;
+    double snr_db = 0;
+    double spur_db = 0;
+    double group_delay_ms = 0;
+    bool reference = false;
+};
+
+template <typename T, typename Roots, typename D, typename I>
+void sweep(std::vector<Row>& rows, const char* resampler, const char* roots,
+           const char* precision)
+{
+    using Design = ::Design<T, Roots, D, I>;
+
+    for (auto band_count : band_counts)
+    {
+        Row row;
+        row.band_count = band_count;
+        row.resampler = resampler;
+        row.roots = roots;
+        row.precision = precision;
+        row.reference = std::is_same_v<Design, Reference> &&
+            (band_count == band_counts.back());
+        row.ns_per_sample = Design::nsPerSample(band_count);
+        row.snr_db = std::numeric_limits<double>::infinity();
+        row.spur_db = -std::numeric_limits<double>::infinity();
+        for (auto v : {voice::up1, voice::down1})
+        {
+            for (size_t signal = 0; signal < test_signals.size(); ++signal)
+            {
+                if (!row.reference && (test_signals[signal].freqs.size() == 1))
+                {
+                    row.snr_db = std::min(row.snr_db,
+                        Design::snr(signal, band_count, v));
+                }
+                row.spur_db = std::max(row.spur_db,
+                    Design::spur(test_signals[signal], band_count, v));
+            }
+            for (auto freq : {82.41, 220.0, 440.0})
+            {
+                row.group_delay_ms = std::max(row.group_delay_ms,
+                    Design::groupDelayMs(freq, band_count, v));
+            }
+        }
+        std::fprintf(stderr, "%4d %s %s %s\n", band_count, resampler, roots,
+                     precision);
+        rows.push_back(row);
+    }
+}
+
+template <typename D, typename I>
+void sweepResampler(std::vector<Row>& rows, const char* resampler)
+{
+    sweep<float, FastRoots, D, I>(rows, resampler, "fast", "float");
+    sweep<float, ExactRoots, D, I>(rows, resampler, "exact", "float");
+    sweep<double, FastRoots, D, I>(rows, resampler, "fast", "double");
+    sweep<double, ExactRoots, D, I>(rows, resampler, "exact", "double");
+}
+
+// Differences that are within the run-to-run variation of the timing or
+// that are inaudible
+struct
+{
+    double cost_ratio = 1.05;
+    double snr_db = 1;
+    double spur_db = 0.5;
+    double group_delay_ms = 1;
+} constexpr tolerance;
+
+// True if a is at least as good as b on every metric and better on one,
+// each by more than the tolerance
+bool dominates(const Row& a, const Row& b)
+{
+    const bool no_worse =
+        (a.ns_per_sample <= b.ns_per_sample * tolerance.cost_ratio) &&
+        (a.snr_db >= b.snr_db - tolerance.snr_db) &&
+        (a.spur_db <= b.spur_db + tolerance.spur_db) &&
+        (a.group_delay_ms <= b.group_delay_ms + tolerance.group_delay_ms);
+    const bool better =
+        (a.ns_per_sample * tolerance.cost_ratio < b.ns_per_sample) ||
+        (a.snr_db - tolerance.snr_db > b.snr_db) ||
+        (a.spur_db + tolerance.spur_db < b.spur_db) ||
+        (a.group_delay_ms + tolerance.group_delay_ms < b.group_delay_ms);
+    return no_worse && better;
+}
+
+void print(std::FILE* file, const Row& row, bool pareto)
+{
+    std::fprintf(file, "%d,%s,%s,%s,%.2f,%.1f,%.1f,%.2f,%d\n",
+        row.band_count, row.resampler.c_str(), row.roots.c_str(),
+        row.precision.c_str(), row.ns_per_sample, row.snr_db, row.spur_db,
+        row.group_delay_ms, pareto ? 1 : 0);
+}
+
+int main(int argc, char* argv[])
+{
+    const auto path = (argc > 1) ? argv[1] : "design_sweep.csv";
+
+    std::vector<Row> rows;
+    sweepResampler<FirDecimator, FirInterpolator>(rows, "fir");
+    sweepResampler<IirDecimator, IirInterpolator>(rows, "iir");
+
+    const char* header = "bands,resampler,roots,precision,ns_per_sample,"
+        "snr_db,spur_db,group_delay_ms,pareto\n";
+
+    auto* file = std::fopen(path, "w");
+    if (!file)
+    {
+        std::fprintf(stderr, "Cannot write %s\n", path);
+        return 1;
+    }
+    std::fputs(header, file);
+
+    std::printf("Reference design:\n");
+    std::fputs(header, stdout);
+    for (const auto& row : rows)
+    {
+        if (row.reference)
+        {
+            print(stdout, row, false);
+        }
+    }
+
+    std::printf("Pareto-optimal designs:\n");
+    std::fputs(header, stdout);
+    for (const auto& row : rows)
+    {
+        const bool pareto = !row.reference &&
+            std::none_of(rows.begin(), rows.end(), [&](const Row& other){
+                return !other.reference && dominates(other, row);
+            });
+        print(file, row, pareto);
+        if (pareto)
+        {
+            print(stdout, row, true);
+        }
+    }
+    std::fclose(file);
+
+    std::printf("All %zu designs written to %s\n", rows.size(), path);
+}
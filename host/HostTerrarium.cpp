@@ -0,0 +1,250 @@
+#include "HostTerrarium.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+
+#include <util/Multirate.h>
+
+HostTerrarium::HostTerrarium(Config config) :
+    _config(std::move(config))
+{
+}
+
+void HostTerrarium::Init(bool)
+{
+    _input = readWav(_config.input_path);
+    if (_input.frames() == 0)
+    {
+        throw std::runtime_error(_config.input_path + " is empty");
+    }
+
+    // The filters of the firmware are designed for this rate only
+    if (_input.sample_rate != 48000)
+    {
+        throw std::runtime_error(_config.input_path + " is not 48 kHz");
+    }
+
+    // The firmware resamples whole blocks to its internal rate
+    if (_config.block_size == 0 || _config.block_size % resample_factor != 0)
+    {
+        throw std::runtime_error(
+            "block size must be a positive multiple of " +
+            std::to_string(resample_factor));
+    }
+
+    // The firmware processes two input and two output channels
+    _input.channels.resize(2, std::vector<float>(_input.frames()));
+    _output.sample_rate = _input.sample_rate;
+    _output.channels.assign(2, std::vector<float>(_input.frames()));
+    _in_block.fill(std::vector<float>(_config.block_size));
+    _out_block.fill(std::vector<float>(_config.block_size));
+
+    if (!_config.timeline_path.empty())
+    {
+        _timeline = readTimeline(_config.timeline_path);
+    }
+}
+
+float HostTerrarium::AudioSampleRate()
+{
+    return _input.sample_rate;
+}
+
+size_t HostTerrarium::AudioBlockSize()
+{
+    return _config.block_size;
+}
+
+void HostTerrarium::StartAudio(AudioCallback callback)
+{
+    _audio_callback = callback;
+}
+
+void HostTerrarium::Loop(float frequency, std::function<void()> callback)
+{
+    const double loop_period = 1.0 / frequency;
+    const double block_period = _config.block_size / _input.sample_rate;
+    const size_t block_count =
+        (_input.frames() + _config.block_size - 1) / _config.block_size;
+
+    const auto wall_begin = Clock::now();
+    size_t next_block = 0;
+    for (size_t tick = 0; next_block < block_count; ++tick)
+    {
+        _now = tick * loop_period;
+        ApplyEvents(_now);
+
+        // Debounce
+        for (int i = 0; i < stomp_count; ++i)
+        {
+            _stomp_edges[i] = _stomps_scripted[i] && !_stomps[i];
+            _stomps[i] = _stomps_scripted[i];
+        }
+
+        const auto begin = Clock::now();
+        callback();
+        _loop_cost.add(Clock::now() - begin);
+
+        const double next_tick = _now + loop_period;
+        while (next_block < block_count &&
+               next_block * block_period < next_tick)
+        {
+            ProcessBlock(next_block++);
+        }
+    }
+    _wall_time = Clock::now() - wall_begin;
+}
+
+float HostTerrarium::ProcessKnob(int index)
+{
+    return _knobs[index];
+}
+
+bool HostTerrarium::StompRisingEdge(int index)
+{
+    return _stomp_edges[index];
+}
+
+bool HostTerrarium::ToggleOn(int index)
+{
+    return _toggles[index];
+}
+
+void HostTerrarium::SetLed(int index, float brightness)
+{
+    if (_leds_set[index] && _leds[index] == brightness)
+    {
+        return;
+    }
+    _leds[index] = brightness;
+    _leds_set[index] = true;
+
+    if (_config.led_log)
+    {
+        char line[64];
+        std::snprintf(line, sizeof(line), "%10.3f s  led %d = %g\n",
+                      _now, index, brightness);
+        *_config.led_log << line;
+    }
+}
+
+uint32_t HostTerrarium::TimerTicks()
+{
+    using std::chrono::nanoseconds;
+    return static_cast<uint32_t>(
+        std::chrono::duration_cast<nanoseconds>(Clock::now() - _start).count());
+}
+
+float HostTerrarium::TimerTickRate()
+{
+    return 1e9 / _config.slowdown;
+}
+
+void HostTerrarium::WriteOutput() const
+{
+    writeWav(_config.output_path, _output);
+}
+
+void HostTerrarium::PrintReport(std::ostream& out) const
+{
+    using std::chrono::duration;
+    const double simulated = _input.frames() / _input.sample_rate;
+    const double wall = duration<double>(_wall_time).count();
+    const double deadline_us = 1e6 * _config.block_size / _input.sample_rate;
+
+    char text[512];
+    std::snprintf(text, sizeof(text),
+        "simulated %.3f s in %.3f s (%.1fx real time)\n"
+        "audio callback: %zu blocks, mean %.2f us, max %.2f us, "
+        "deadline %.2f us, %zu over deadline\n"
+        "loop callback: %zu iterations, mean %.2f us, max %.2f us\n",
+        simulated, wall, (wall > 0) ? simulated / wall : 0.0,
+        _audio_cost.count, _audio_cost.mean_us(),
+        duration<double, std::micro>(_audio_cost.max).count(),
+        deadline_us, _audio_overruns,
+        _loop_cost.count, _loop_cost.mean_us(),
+        duration<double, std::micro>(_loop_cost.max).count());
+    out << text;
+}
+
+void HostTerrarium::ApplyEvents(double until)
+{
+    for (; _next_event < _timeline.size(); ++_next_event)
+    {
+        const auto& event = _timeline[_next_event];
+        if (event.time > until)
+        {
+            break;
+        }
+
+        switch (event.control)
+        {
+        case TimelineEvent::Control::knob:
+            _knobs[event.index] = event.value;
+            break;
+        case TimelineEvent::Control::stomp:
+            _stomps_scripted[event.index] = (event.value > 0);
+            break;
+        case TimelineEvent::Control::toggle:
+            _toggles[event.index] = (event.value > 0);
+            break;
+        }
+    }
+}
+
+void HostTerrarium::ProcessBlock(size_t block)
+{
+    const auto size = _config.block_size;
+    const auto offset = block * size;
+    const auto valid = std::min(size, _input.frames() - offset);
+
+    // The final block is padded with silence
+    std::array<const float*, 2> in_ptrs;
+    std::array<float*, 2> out_ptrs;
+    for (size_t c = 0; c < 2; ++c)
+    {
+        const auto input = _input.channels[c].begin() + offset;
+        std::fill(std::copy_n(input, valid, _in_block[c].begin()),
+                  _in_block[c].end(), 0.0f);
+        std::fill(_out_block[c].begin(), _out_block[c].end(), 0.0f);
+        in_ptrs[c] = _in_block[c].data();
+        out_ptrs[c] = _out_block[c].data();
+    }
+
+    if (!_audio_callback)
+    {
+        return;
+    }
+
+    const auto begin = Clock::now();
+    _audio_callback(in_ptrs.data(), out_ptrs.data(), size);
+    const auto cost = std::chrono::duration_cast<Clock::duration>(
+        (Clock::now() - begin) * _config.slowdown);
+
+    _audio_cost.add(cost);
+    if (cost > std::chrono::duration<double>(size / _input.sample_rate))
+    {
+        ++_audio_overruns;
+    }
+
+    for (size_t c = 0; c < 2; ++c)
+    {
+        std::copy_n(_out_block[c].begin(), valid,
+                    _output.channels[c].begin() + offset);
+    }
+}
+
+void HostTerrarium::CostStats::add(Clock::duration d)
+{
+    ++count;
+    total += d;
+    max = std::max(max, d);
+}
+
+double HostTerrarium::CostStats::mean_us() const
+{
+    using std::chrono::duration;
+    return count ? duration<double, std::micro>(total).count() / count : 0;
+}
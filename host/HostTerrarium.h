@@ -0,0 +1,103 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include <util/Terrarium.h>
+
+#include "Timeline.h"
+#include "Wav.h"
+
+// Simulated Terrarium for running the firmware on a desktop machine.
+//
+// Audio is read from a WAV file and written to another. Knobs and switches
+// follow a timeline file, and LED changes are logged. Everything runs on a
+// simulated clock as fast as the host allows: each loop iteration applies the
+// timeline events that are due, runs the loop callback, and then runs the
+// audio callback for every block that starts before the next iteration.
+// Loop() returns once the input has been consumed.
+class HostTerrarium : public Terrarium
+{
+public:
+    struct Config
+    {
+        std::string input_path;
+        std::string output_path;
+        // Optional; without a timeline all controls stay at zero
+        std::string timeline_path;
+        size_t block_size = 48;
+        std::ostream* led_log = nullptr;
+        // Emulates a slower processor: processing times, as seen through
+        // TimerTicks() and in the report, are multiplied by this factor.
+        double slowdown = 1;
+    };
+
+    explicit HostTerrarium(Config config);
+
+    // Loads the input and timeline files.
+    // Throws std::runtime_error if they cannot be read.
+    void Init(bool boost = false) override;
+
+    float AudioSampleRate() override;
+    size_t AudioBlockSize() override;
+    void StartAudio(AudioCallback callback) override;
+    void Loop(float frequency, std::function<void()> callback) override;
+
+    float ProcessKnob(int index) override;
+    bool StompRisingEdge(int index) override;
+    bool ToggleOn(int index) override;
+    void SetLed(int index, float brightness) override;
+    uint32_t TimerTicks() override;
+    float TimerTickRate() override;
+
+    // Writes the audio produced by the firmware to the output file.
+    void WriteOutput() const;
+
+    // Prints the simulated and host durations and the callback costs.
+    void PrintReport(std::ostream& out) const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct CostStats
+    {
+        void add(Clock::duration d);
+        double mean_us() const;
+
+        size_t count = 0;
+        Clock::duration total{};
+        Clock::duration max{};
+    };
+
+    void ApplyEvents(double until);
+    void ProcessBlock(size_t block);
+
+    Config _config;
+    Clock::time_point _start = Clock::now();
+    WavData _input;
+    WavData _output;
+    std::vector<TimelineEvent> _timeline;
+    size_t _next_event = 0;
+    double _now = 0;
+
+    AudioCallback _audio_callback = nullptr;
+    std::array<std::vector<float>, 2> _in_block;
+    std::array<std::vector<float>, 2> _out_block;
+
+    std::array<float, knob_count> _knobs{};
+    std::array<bool, stomp_count> _stomps_scripted{};
+    std::array<bool, stomp_count> _stomps{};
+    std::array<bool, stomp_count> _stomp_edges{};
+    std::array<bool, toggle_count> _toggles{};
+    std::array<float, led_count> _leds{};
+    std::array<bool, led_count> _leds_set{};
+
+    CostStats _audio_cost;
+    CostStats _loop_cost;
+    size_t _audio_overruns = 0;
+    Clock::duration _wall_time{};
+};
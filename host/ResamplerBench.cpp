@@ -0,0 +1,171 @@
+// Compares the FIR and polyphase IIR resampler engines in Multirate.h:
+// cost per 48 kHz sample, group delay across the pass band, and rejection of
+// the aliases and images that fall onto the pass band.
+
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <complex>
+#include <cstdio>
+#include <numbers>
+#include <vector>
+
+#include <util/Multirate.h>
+
+constexpr double sample_rate = 48000;
+constexpr double low_rate = sample_rate / resample_factor;
+constexpr auto pi = std::numbers::pi;
+
+// Complex amplitude of the given frequency in a signal
+std::complex<double> measure(
+    const std::vector<float>& x, double freq, double rate)
+{
+    std::complex<double> acc = 0;
+    for (size_t n = 0; n < x.size(); ++n)
+    {
+        acc += double(x[n]) * std::polar(1.0, -2 * pi * freq * n / rate);
+    }
+    return acc * (2.0 / x.size());
+}
+
+template <typename D>
+std::vector<float> decimateSine(double freq, size_t frames)
+{
+    D decimate;
+    std::vector<float> out;
+    std::array<float, resample_factor> chunk;
+    size_t n = 0;
+    for (size_t i = 0; i < frames; ++i)
+    {
+        for (auto& x : chunk)
+        {
+            x = std::sin(2 * pi * freq * n++ / sample_rate);
+        }
+        out.push_back(decimate(chunk));
+    }
+    return out;
+}
+
+template <typename I>
+std::vector<float> interpolateSine(double freq, size_t frames)
+{
+    I interpolate;
+    std::vector<float> out;
+    for (size_t i = 0; i < frames; ++i)
+    {
+        const auto chunk =
+            interpolate(std::sin(2 * pi * freq * i / low_rate));
+        out.insert(out.end(), chunk.begin(), chunk.end());
+    }
+    return out;
+}
+
+// Skips the start-up transient
+std::vector<float> settled(const std::vector<float>& x)
+{
+    return {x.begin() + x.size() / 4, x.end()};
+}
+
+// Group delay in 48 kHz samples, from the phase slope around freq
+template <typename F>
+double groupDelay(F run, double freq, double rate)
+{
+    constexpr double df = 10;
+    const auto phase = [&](double f){
+        const auto y = settled(run(f));
+        // Reference phase of the input at the first settled output sample
+        const auto t0 = double(y.size() / 3) / rate;
+        return std::arg(measure(y, f, rate) *
+                        std::polar(1.0, 2 * pi * f * t0));
+    };
+    auto d = phase(freq + df) - phase(freq - df);
+    d = std::remainder(d, 2 * pi);
+    return -d / (2 * pi * 2 * df) * sample_rate;
+}
+
+template <typename D, typename I>
+void report(const char* name)
+{
+    using clock = std::chrono::steady_clock;
+    constexpr size_t frames = 8000;
+
+    // Cost
+    D decimate;
+    I interpolate;
+    std::array<float, resample_factor> chunk{};
+    float sink = 0;
+    const auto begin = clock::now();
+    for (size_t i = 0; i < 200 * frames; ++i)
+    {
+        chunk[i % resample_factor] = float(i % 7) - 3;
+        const auto out = interpolate(decimate(chunk));
+        sink += out[0];
+    }
+    const auto end = clock::now();
+    const double ns = std::chrono::duration<double, std::nano>(
+        end - begin).count() / (200 * frames * resample_factor);
+
+    std::printf("%s (checksum %g)\n", name, sink);
+    std::printf("  cost: %.2f ns per 48 kHz sample (decimate + interpolate)\n",
+        ns);
+
+    const auto dec = [&](double f){ return decimateSine<D>(f, frames); };
+    const auto interp = [&](double f){
+        return interpolateSine<I>(f, frames);
+    };
+
+    const auto gain = [](const std::vector<float>& y, double f, double rate){
+        return 20 * std::log10(std::abs(measure(settled(y), f, rate)));
+    };
+
+    std::printf("  pass band group delay (48 kHz samples) and gain (dB):\n");
+    std::printf("    %8s %20s %20s\n", "Hz", "decimator", "interpolator");
+    for (double f : {100.0, 500.0, 1000.0, 1800.0, 3600.0})
+    {
+        std::printf("    %8.0f ", f);
+        if (f <= 1800)
+        {
+            std::printf("%12.2f %7.3f ", groupDelay(dec, f, low_rate),
+                gain(dec(f), f, low_rate));
+        }
+        else
+        {
+            std::printf("%12s %7s ", "-", "-");
+        }
+        std::printf("%12.2f %7.3f\n", groupDelay(interp, f, sample_rate),
+            gain(interp(f), f, sample_rate));
+    }
+
+    // Aliases onto the pass band: 48 kHz input at f lands at
+    // |f - 16000| after the first stage
+    std::printf("  decimator alias level (dB):\n");
+    for (double f : {14400.0, 15000.0, 16500.0, 17500.0})
+    {
+        const auto alias = std::abs(f - 16000);
+        const auto pass = std::abs(measure(settled(dec(alias)), alias,
+                                           low_rate));
+        const auto leak = std::abs(measure(settled(dec(f)), alias,
+                                           low_rate));
+        std::printf("    %8.0f Hz -> %6.0f Hz: %7.1f\n",
+            f, alias, 20 * std::log10(leak / pass));
+    }
+
+    std::printf("  interpolator image level (dB):\n");
+    for (double f : {500.0, 1000.0, 1800.0, 3600.0})
+    {
+        const auto y = settled(interp(f));
+        const auto pass = std::abs(measure(y, f, sample_rate));
+        for (double image : {low_rate * 2 - f, low_rate * 2 + f})
+        {
+            const auto leak = std::abs(measure(y, image, sample_rate));
+            std::printf("    %8.0f Hz -> %6.0f Hz: %7.1f\n",
+                f, image, 20 * std::log10(leak / pass));
+        }
+    }
+}
+
+int main()
+{
+    report<FirDecimator, FirInterpolator>("FIR");
+    report<IirDecimator, IirInterpolator>("IIR");
+}
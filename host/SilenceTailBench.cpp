@@ -0,0 +1,136 @@
+// Measures the per-block cost of the firmware signal chain during a long
+// silence tail after a loud input, with and without flush-to-zero. While the
+// recursive filter states decay through the subnormal range, the cost of
+// silence can rise far above the cost of signal on hosts without FTZ.
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <numbers>
+#include <vector>
+
+#include <q/support/literals.hpp>
+#include <q/fx/biquad.hpp>
+
+#include <util/BandShifter.h>
+#include <util/Denormals.h>
+#include <util/Multirate.h>
+#include <util/OctaveGenerator.h>
+
+namespace q = cycfi::q;
+using namespace q::literals;
+
+constexpr float sample_rate = 48000;
+constexpr size_t block_size = 48;
+constexpr int loud_seconds = 1;
+constexpr int tail_seconds = 20;
+
+//=============================================================================
+// Same chain as processAudioBlock, with every voice enabled.
+class SignalChain
+{
+public:
+    void process(const float* in, float* out, size_t size)
+    {
+        for (size_t i = 0; i <= (size - resample_factor); i += resample_factor)
+        {
+            std::span<const float, resample_factor> in_chunk(
+                &(in[i]), resample_factor);
+            const auto sample = decimate(in_chunk);
+
+            octave.update(sample);
+            const float octave_mix = octave.up1() + octave.down1() +
+                octave.down2() + octave.up2() + octave.down3();
+
+            auto out_chunk = interpolate(octave_mix);
+            for (size_t j = 0; j < out_chunk.size(); ++j)
+            {
+                out[i+j] = eq2(eq1(out_chunk[j])) + in[i+j];
+            }
+        }
+    }
+
+private:
+    Decimator decimate;
+    Interpolator interpolate;
+    OctaveGenerator octave{sample_rate / resample_factor};
+    q::highshelf eq1{-11, 140_Hz, sample_rate};
+    q::lowshelf eq2{5, 160_Hz, sample_rate};
+};
+
+//=============================================================================
+struct SecondStats
+{
+    double mean_us = 0;
+    double max_us = 0;
+};
+
+std::vector<SecondStats> run()
+{
+    using clock = std::chrono::steady_clock;
+    constexpr auto pi = std::numbers::pi_v<float>;
+    constexpr auto blocks_per_second = size_t(sample_rate) / block_size;
+
+    SignalChain chain;
+    std::array<float, block_size> in;
+    std::array<float, block_size> out;
+    std::vector<SecondStats> stats;
+    float sink = 0;
+    size_t n = 0;
+
+    for (int second = 0; second < loud_seconds + tail_seconds; ++second)
+    {
+        SecondStats s;
+        for (size_t b = 0; b < blocks_per_second; ++b)
+        {
+            for (auto& x : in)
+            {
+                // Loud chord spanning the band layout, then silence
+                const float t = n++ / sample_rate;
+                x = (second < loud_seconds) ?
+                    0.3f * (std::sin(2*pi*82.4f*t) +
+                            std::sin(2*pi*196.0f*t) +
+                            std::sin(2*pi*659.3f*t)) :
+                    0.0f;
+            }
+
+            const auto begin = clock::now();
+            chain.process(in.data(), out.data(), block_size);
+            const auto end = clock::now();
+
+            const double us =
+                std::chrono::duration<double, std::micro>(end - begin).count();
+            s.mean_us += us / blocks_per_second;
+            s.max_us = std::max(s.max_us, us);
+            sink += out[0];
+        }
+        stats.push_back(s);
+    }
+
+    // Keep the optimizer from discarding the chain
+    std::printf("(checksum %g)\n", sink);
+    return stats;
+}
+
+int main()
+{
+    const double deadline_us = 1e6 * block_size / sample_rate;
+
+    const auto normal = run();
+    enableFlushToZero();
+    const auto ftz = run();
+
+    std::printf("block size %zu, deadline %.1f us\n", block_size, deadline_us);
+    std::printf("%8s %14s %14s %14s %14s\n", "second",
+        "mean us", "max us", "mean us (FTZ)", "max us (FTZ)");
+    for (size_t i = 0; i < normal.size(); ++i)
+    {
+        std::printf("%7zu%s %14.2f %14.2f %14.2f %14.2f\n",
+            i, (i < loud_seconds) ? "*" : " ",
+            normal[i].mean_us, normal[i].max_us,
+            ftz[i].mean_us, ftz[i].max_us);
+    }
+    std::printf("* loud input\n");
+}
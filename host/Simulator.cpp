@@ -0,0 +1,72 @@
+// Runs the complete firmware on simulated Terrarium hardware.
+//
+//   TerrariumSim [--block-size N] [--slowdown X] input.wav output.wav [timeline.txt]
+//
+// See Timeline.h for the timeline file format.
+
+#include <cstdio>
+#include <exception>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <Firmware.h>
+
+#include "HostTerrarium.h"
+
+int main(int argc, char* argv[])
+{
+    HostTerrarium::Config config;
+    config.led_log = &std::cout;
+
+    std::vector<std::string> paths;
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string arg = argv[i];
+        if (arg == "--block-size" && i + 1 < argc)
+        {
+            config.block_size = std::stoul(argv[++i]);
+        }
+        else if (arg == "--slowdown" && i + 1 < argc)
+        {
+            config.slowdown = std::stod(argv[++i]);
+        }
+        else
+        {
+            paths.push_back(arg);
+        }
+    }
+
+    if (paths.size() < 2 || paths.size() > 3)
+    {
+        std::fprintf(stderr, "usage: %s [--block-size N] [--slowdown X] "
+                     "input.wav output.wav [timeline.txt]\n", argv[0]);
+        return 2;
+    }
+    config.input_path = paths[0];
+    config.output_path = paths[1];
+    if (paths.size() == 3)
+    {
+        config.timeline_path = paths[2];
+    }
+
+    try
+    {
+        HostTerrarium terrarium(config);
+        runFirmware(terrarium);
+        terrarium.WriteOutput();
+        terrarium.PrintReport(std::cout);
+
+        const auto& shedder = loadShedder();
+        std::printf("load shedding: %u events, %u blocks shed, "
+                    "max level %d, peak load %.2f\n",
+                    unsigned(shedder.shedEvents()),
+                    unsigned(shedder.shedBlocks()), shedder.maxLevel(),
+                    shedder.peakLoad());
+    }
+    catch (const std::exception& e)
+    {
+        std::fprintf(stderr, "error: %s\n", e.what());
+        return 1;
+    }
+}
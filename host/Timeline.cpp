@@ -0,0 +1,107 @@
+#include "Timeline.h"
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+#include <util/Terrarium.h>
+
+namespace
+{
+    struct ControlInfo
+    {
+        const char* name;
+        TimelineEvent::Control control;
+        int count;
+        const char* on;
+        const char* off;
+    };
+
+    constexpr ControlInfo controls[] = {
+        {"knob", TimelineEvent::Control::knob, Terrarium::knob_count,
+            nullptr, nullptr},
+        {"stomp", TimelineEvent::Control::stomp, Terrarium::stomp_count,
+            "press", "release"},
+        {"toggle", TimelineEvent::Control::toggle, Terrarium::toggle_count,
+            "on", "off"},
+    };
+
+    TimelineEvent parseEvent(const std::string& line)
+    {
+        std::istringstream in(line);
+        TimelineEvent event;
+        std::string name;
+        std::string value;
+        if (!(in >> event.time >> name >> event.index >> value))
+        {
+            throw std::runtime_error("expected: <seconds> <control> "
+                                     "<index> <value>");
+        }
+
+        const auto info = std::find_if(
+            std::begin(controls), std::end(controls),
+            [&](const auto& c){ return name == c.name; });
+        if (info == std::end(controls))
+        {
+            throw std::runtime_error("unknown control '" + name + "'");
+        }
+        event.control = info->control;
+
+        if (event.index < 0 || event.index >= info->count)
+        {
+            throw std::runtime_error("no " + name + " with index " +
+                                     std::to_string(event.index));
+        }
+
+        if (!info->on)
+        {
+            event.value = std::clamp(std::stof(value), 0.0f, 1.0f);
+        }
+        else if (value == info->on || value == info->off)
+        {
+            event.value = (value == info->on) ? 1 : 0;
+        }
+        else
+        {
+            throw std::runtime_error(name + " expects '" + info->on +
+                                     "' or '" + info->off + "'");
+        }
+
+        return event;
+    }
+}
+
+std::vector<TimelineEvent> readTimeline(const std::string& path)
+{
+    std::ifstream in(path);
+    if (!in)
+    {
+        throw std::runtime_error("cannot open " + path);
+    }
+
+    std::vector<TimelineEvent> events;
+    std::string line;
+    for (int line_number = 1; std::getline(in, line); ++line_number)
+    {
+        const auto begin = line.find_first_not_of(" \t\r");
+        if (begin == std::string::npos || line[begin] == '#')
+        {
+            continue;
+        }
+
+        try
+        {
+            events.push_back(parseEvent(line));
+        }
+        catch (const std::exception& e)
+        {
+            throw std::runtime_error(path + ":" +
+                std::to_string(line_number) + ": " + e.what());
+        }
+    }
+
+    std::stable_sort(events.begin(), events.end(),
+        [](const auto& a, const auto& b){ return a.time < b.time; });
+    return events;
+}
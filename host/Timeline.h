@@ -0,0 +1,26 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+// Scripted control changes for the simulator. A timeline file holds one event
+// per line; blank lines and lines starting with '#' are ignored.
+//
+//   <seconds> knob <index> <position 0..1>
+//   <seconds> stomp <index> press|release
+//   <seconds> toggle <index> on|off
+//
+// Indices are zero-based, as in the firmware.
+struct TimelineEvent
+{
+    enum class Control { knob, stomp, toggle };
+
+    double time = 0;
+    Control control = Control::knob;
+    int index = 0;
+    float value = 0;
+};
+
+// Returns the events sorted by time.
+// Throws std::runtime_error if the file cannot be read or parsed.
+std::vector<TimelineEvent> readTimeline(const std::string& path);
@@ -0,0 +1,165 @@
+#include "Wav.h"
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+namespace
+{
+    constexpr uint16_t format_pcm = 1;
+    constexpr uint16_t format_float = 3;
+    constexpr uint16_t format_extensible = 0xFFFE;
+
+    uint32_t readLE(const uint8_t* p, int bytes)
+    {
+        uint32_t value = 0;
+        for (int i = 0; i < bytes; ++i)
+        {
+            value |= uint32_t(p[i]) << (8 * i);
+        }
+        return value;
+    }
+
+    void writeLE(std::ostream& out, uint32_t value, int bytes)
+    {
+        for (int i = 0; i < bytes; ++i)
+        {
+            out.put(static_cast<char>((value >> (8 * i)) & 0xFF));
+        }
+    }
+
+    float decodeSample(const uint8_t* p, uint16_t format, uint16_t bits)
+    {
+        if (format == format_float)
+        {
+            float value;
+            std::memcpy(&value, p, sizeof(value));
+            return value;
+        }
+
+        const int bytes = bits / 8;
+        const auto raw = readLE(p, bytes);
+        // Sign-extend to 32 bits, then scale to [-1, 1)
+        const auto value = static_cast<int32_t>(raw << (32 - bits));
+        return value / 2147483648.0f;
+    }
+}
+
+WavData readWav(const std::string& path)
+{
+    std::ifstream in(path, std::ios::binary);
+    if (!in)
+    {
+        throw std::runtime_error("cannot open " + path);
+    }
+
+    uint8_t riff[12];
+    if (!in.read(reinterpret_cast<char*>(riff), sizeof(riff)) ||
+        std::memcmp(riff, "RIFF", 4) || std::memcmp(riff + 8, "WAVE", 4))
+    {
+        throw std::runtime_error(path + " is not a WAVE file");
+    }
+
+    uint16_t format = 0;
+    uint16_t channel_count = 0;
+    uint16_t bits = 0;
+    WavData wav;
+
+    uint8_t header[8];
+    while (in.read(reinterpret_cast<char*>(header), sizeof(header)))
+    {
+        std::vector<uint8_t> chunk(readLE(header + 4, 4));
+        in.read(reinterpret_cast<char*>(chunk.data()), chunk.size());
+        // Tolerate a truncated final chunk
+        const size_t size = in.gcount();
+        if (chunk.size() & 1)
+        {
+            in.ignore(1);
+        }
+
+        if (!std::memcmp(header, "fmt ", 4) && size >= 16)
+        {
+            format = readLE(&chunk[0], 2);
+            channel_count = readLE(&chunk[2], 2);
+            wav.sample_rate = readLE(&chunk[4], 4);
+            bits = readLE(&chunk[14], 2);
+            if (format == format_extensible && size >= 26)
+            {
+                format = readLE(&chunk[24], 2);
+            }
+        }
+        else if (!std::memcmp(header, "data", 4))
+        {
+            const bool supported =
+                (format == format_pcm &&
+                    (bits == 16 || bits == 24 || bits == 32)) ||
+                (format == format_float && bits == 32);
+            if (!supported || channel_count == 0)
+            {
+                throw std::runtime_error(
+                    path + " has an unsupported sample format");
+            }
+
+            const size_t frame_bytes = channel_count * (bits / 8);
+            const size_t frames = size / frame_bytes;
+            wav.channels.assign(channel_count, std::vector<float>(frames));
+            for (size_t i = 0; i < frames; ++i)
+            {
+                for (size_t c = 0; c < channel_count; ++c)
+                {
+                    wav.channels[c][i] = decodeSample(
+                        &chunk[i * frame_bytes + c * (bits / 8)],
+                        format, bits);
+                }
+            }
+            return wav;
+        }
+    }
+
+    throw std::runtime_error(path + " has no audio data");
+}
+
+void writeWav(const std::string& path, const WavData& wav)
+{
+    std::ofstream out(path, std::ios::binary);
+    if (!out)
+    {
+        throw std::runtime_error("cannot create " + path);
+    }
+
+    const uint32_t channel_count = wav.channels.size();
+    const uint32_t frame_bytes = channel_count * sizeof(float);
+    const uint32_t data_bytes = wav.frames() * frame_bytes;
+    const auto sample_rate = static_cast<uint32_t>(wav.sample_rate);
+
+    out.write("RIFF", 4);
+    writeLE(out, 36 + data_bytes, 4);
+    out.write("WAVE", 4);
+
+    out.write("fmt ", 4);
+    writeLE(out, 16, 4);
+    writeLE(out, format_float, 2);
+    writeLE(out, channel_count, 2);
+    writeLE(out, sample_rate, 4);
+    writeLE(out, sample_rate * frame_bytes, 4);
+    writeLE(out, frame_bytes, 2);
+    writeLE(out, 32, 2);
+
+    out.write("data", 4);
+    writeLE(out, data_bytes, 4);
+    for (size_t i = 0; i < wav.frames(); ++i)
+    {
+        for (const auto& channel : wav.channels)
+        {
+            uint32_t bits;
+            std::memcpy(&bits, &channel[i], sizeof(bits));
+            writeLE(out, bits, 4);
+        }
+    }
+
+    if (!out)
+    {
+        throw std::runtime_error("cannot write " + path);
+    }
+}
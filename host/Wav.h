@@ -0,0 +1,24 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+// Minimal RIFF/WAVE support for the host tools.
+struct WavData
+{
+    float sample_rate = 48000;
+    std::vector<std::vector<float>> channels;
+
+    size_t frames() const
+    {
+        return channels.empty() ? 0 : channels[0].size();
+    }
+};
+
+// Reads 16, 24 or 32 bit integer PCM, or 32 bit float samples.
+// Throws std::runtime_error if the file cannot be read.
+WavData readWav(const std::string& path);
+
+// Writes 32 bit float samples.
+// Throws std::runtime_error if the file cannot be written.
+void writeWav(const std::string& path, const WavData& wav);
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+
+//=============================================================================
+// Cascade of first-order allpass sections, each
+//
+// A(z) = (a + z^-1) / (1 + a z^-1)
+//
+// Used as the branches of polyphase IIR filters, where each branch runs at
+// the low sample rate. One multiply per section.
+template <std::size_t N>
+class AllpassChain
+{
+public:
+    constexpr AllpassChain(const std::array<float, N>& coefs) :
+        _coefs(coefs)
+    {
+    }
+
+    float operator()(float x)
+    {
+        // _state[i] is the previous input of section i, which is also the
+        // previous output of section i-1
+        for (std::size_t i = 0; i < N; ++i)
+        {
+            const auto y = _coefs[i] * (x - _state[i+1]) + _state[i];
+            _state[i] = x;
+            x = y;
+        }
+        _state[N] = x;
+        return x;
+    }
+
+private:
+    std::array<float, N> _coefs;
+    std::array<float, N+1> _state{};
+};
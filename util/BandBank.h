@@ -0,0 +1,126 @@
+#pragma once
+
+#include <cmath>
+#include <concepts>
+#include <cstdlib>
+#include <vector>
+
+#include <util/BandShifter.h>
+
+#include <gcem.hpp>
+
+//=============================================================================
+// Placement of the analysis bands. Center frequencies follow an exponential
+// curve from min_freq to max_freq; each bandwidth is derived from the spacing
+// of its neighbors and multiplied by bandwidth_scale. The defaults are the
+// original layout: centerFreq(n) = 480 * 2^(0.027 n) - 420, n = 0..79
+//
+// Banks with uniformly spaced bands (DftBank) use band_count, min_freq,
+// max_freq and bandwidth_scale only; see there.
+struct BandLayout
+{
+    static constexpr int max_band_count = 320;
+
+    int band_count = 80;
+    float min_freq = 60;
+    float max_freq = 480 * gcem::pow(2.0f, 0.027f * 79) - 420;
+    float bandwidth_scale = 1;
+
+    bool operator==(const BandLayout&) const = default;
+
+    float centerFreq(float n) const
+    {
+        const auto t = n / (band_count - 1);
+        return min_freq + (max_freq - min_freq) *
+            (std::exp2(curve * t) - 1) / (std::exp2(curve) - 1);
+    }
+
+    float bandwidth(int n) const
+    {
+        const float f0 = centerFreq(n-1);
+        const float f1 = centerFreq(n);
+        const float f2 = centerFreq(n+1);
+        const float a = (f2 - f1);
+        const float b = (f1 - f0);
+        return bandwidth_scale * 2.0f * (a*b) / (a+b);
+    }
+
+private:
+    static constexpr float curve = 0.027f * 79;
+};
+
+//=============================================================================
+// Output of a band bank for one sample: each voice summed over the bands.
+template <typename T>
+struct VoiceMix
+{
+    T up1 = 0;
+    T down1 = 0;
+    T down2 = 0;
+    T up2 = 0;
+    T down3 = 0;
+};
+
+//=============================================================================
+// Interface of the analysis engines of BasicOctaveGenerator. A bank splits
+// the input into bands with complex analytic outputs and feeds each band to
+// a BasicBandShifter, which performs the octave shifts.
+//
+//   resize(layout, sample_rate)
+//       Sizes the bank for the layout; may allocate. The number of bands
+//       may differ from layout.band_count.
+//   build(layout, sample_rate, begin, end)
+//       Computes bands [begin, end) of the layout, after resize().
+//   carryStateFrom(old)
+//       Takes over the state of a bank with a previous layout.
+//   update(sample, band_count, voices)
+//       Processes one input sample with the first band_count bands and
+//       returns the selected voices summed over them. Must not allocate.
+//
+// shifters, centers and bandwidths hold one entry per band, with centers
+// in ascending order.
+template <typename B>
+concept BandBank = requires(
+    B bank, const B& old, const BandLayout& layout,
+    typename B::Sample sample, unsigned voices)
+{
+    typename B::Sample;
+    typename B::Shifter;
+    bank.resize(layout, 1.0f);
+    bank.build(layout, 1.0f, 0, 1);
+    bank.carryStateFrom(old);
+    { bank.update(sample, 1, voices) } ->
+        std::same_as<VoiceMix<typename B::Sample>>;
+    { bank.shifters } -> std::same_as<std::vector<typename B::Shifter>&>;
+    { bank.centers } -> std::same_as<std::vector<float>&>;
+    { bank.bandwidths } -> std::same_as<std::vector<float>&>;
+};
+
+//=============================================================================
+// Copies the state of the old band nearest to each new band, if it lies
+// within the new band's pass band. Centers are ascending.
+template <typename Bank>
+void carryShifterState(Bank& bank, const Bank& old)
+{
+    if (old.centers.empty())
+    {
+        return;
+    }
+
+    size_t j = 0;
+    for (size_t i = 0; i < bank.shifters.size(); ++i)
+    {
+        const auto center = bank.centers[i];
+        while ((j + 1 < old.centers.size()) &&
+               (std::abs(old.centers[j+1] - center) <=
+                std::abs(old.centers[j] - center)))
+        {
+            ++j;
+        }
+
+        if (std::abs(old.centers[j] - center) <= 0.5f * bank.bandwidths[i])
+        {
+            bank.shifters[i].copyState(old.shifters[j]);
+        }
+    }
+}
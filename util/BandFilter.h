@@ -0,0 +1,211 @@
+#pragma once
+
+#include <array>
+#include <cmath>
+#include <complex>
+#include <cstddef>
+#include <numbers>
+#include <span>
+
+//=============================================================================
+// Coefficients of the complex band-pass filter of a BandShifter:
+//
+//   y[n]  = s2[n-1] + d0 x[n]
+//   s2[n] = s1[n-1] + d1 x[n] - c1 y[n]
+//   s1[n] = d2 x[n] - c2 y[n]
+//
+// Prototype filter is LPF from "Cookbook formulae for audio EQ biquad
+// filter coefficients", a.k.a. "Audio EQ Cookbook",
+// by Robert Bristow-Johnson
+// https://webaudio.github.io/Audio-EQ-Cookbook/audio-eq-cookbook.html
+//
+// Transformed as described in Section 3.1 of "Complex Band-Pass Filters
+// for Analytic Signal Generation and Their Application" by Andrew J. Noga
+// https://apps.dtic.mil/sti/tr/pdf/ADA395963.pdf
+struct BandFilterCoefficients
+{
+    BandFilterCoefficients(float center, float sample_rate, float bw)
+    {
+        constexpr auto pi = std::numbers::pi_v<double>;
+        constexpr auto j = std::complex<double>(0, 1);
+
+        const auto w0 = pi * bw / sample_rate;
+        const auto cos_w0 = std::cos(w0);
+        const auto sin_w0 = std::sin(w0);
+        const auto sqrt_2 = std::sqrt(2.0);
+        const auto a0 = (1 + sqrt_2 * sin_w0 / 2);
+        const auto g = (1 - cos_w0) / (2 * a0);
+
+        const auto w1 = 2 * pi * center / sample_rate;
+        const auto e1 = std::exp(j * w1);
+        const auto e2 = std::exp(j * w1 * 2.0);
+
+        d0 = g;
+        d1 = e1 * 2.0 * g;
+        d2 = e2 * g;
+        c1 = e1 * (-2 * cos_w0) / a0;
+        c2 = e2 * (1 - sqrt_2 * sin_w0 / 2) / a0;
+    }
+
+    double d0;
+    std::complex<double> d1;
+    std::complex<double> d2;
+    std::complex<double> c1;
+    std::complex<double> c2;
+};
+
+//=============================================================================
+// Block state-space form of the band filter: computes K outputs at once from
+// the state (s1, s2) and K inputs, and advances the state by K samples.
+//
+// With the state z = (s1, s2) the recursion above is
+//
+//   z[n] = A z[n-1] + B x[n]      A = | 0  -c2 |   B = | d2 - c2 d0 |
+//   y[n] = C z[n-1] + d0 x[n]         | 1  -c1 |       | d1 - c1 d0 |
+//                                 C = | 0   1  |
+//
+// so that over a block
+//
+//   y[k]  = C A^k z[-1] + d0 x[k] + sum_{j<k} C A^(k-1-j) B x[j]
+//   z[K-1] = A^K z[-1] + sum_{j<K} A^(K-1-j) B x[j]
+//
+// The outputs of a block do not depend on each other, so the time steps can
+// be computed in parallel (e.g. as SIMD lanes). The matrices are computed in
+// double precision and rounded to T; the block form then differs from the
+// recursion only by rounding.
+template <typename T, size_t K>
+class BlockBandFilter
+{
+public:
+    static constexpr size_t block_size = K;
+
+    BlockBandFilter() = default;
+
+    explicit BlockBandFilter(const BandFilterCoefficients& c)
+    {
+        using complex = std::complex<double>;
+        using Matrix = std::array<std::array<complex, 2>, 2>;
+
+        const auto multiply = [](const Matrix& a, const Matrix& b){
+            Matrix r{};
+            for (int i = 0; i < 2; ++i)
+            {
+                for (int j = 0; j < 2; ++j)
+                {
+                    r[i][j] = a[i][0] * b[0][j] + a[i][1] * b[1][j];
+                }
+            }
+            return r;
+        };
+
+        const Matrix a{{{0.0, -c.c2}, {1.0, -c.c1}}};
+        const std::array<complex, 2> b{c.d2 - c.c2 * c.d0, c.d1 - c.c1 * c.d0};
+
+        // powers[k] = A^k
+        std::array<Matrix, K + 1> powers;
+        powers[0] = Matrix{{{1.0, 0.0}, {0.0, 1.0}}};
+        for (size_t k = 0; k < K; ++k)
+        {
+            powers[k+1] = multiply(powers[k], a);
+        }
+
+        // C A^m B, the impulse response after the direct term
+        const auto response = [&](size_t m){
+            return powers[m][1][0] * b[0] + powers[m][1][1] * b[1];
+        };
+
+        for (size_t k = 0; k < K; ++k)
+        {
+            // Second row of A^k, i.e. C A^k
+            set(_y_s1, k, powers[k][1][0]);
+            set(_y_s2, k, powers[k][1][1]);
+
+            for (size_t j = 0; j < K; ++j)
+            {
+                const auto h = (j == k) ? complex(c.d0) :
+                    (j < k) ? response(k - 1 - j) : complex(0.0);
+                set(_y_x[j], k, h);
+            }
+        }
+
+        for (int i = 0; i < 2; ++i)
+        {
+            for (int j = 0; j < 2; ++j)
+            {
+                _z_z[i][j] = std::complex<T>(
+                    powers[K][i][j].real(), powers[K][i][j].imag());
+            }
+        }
+
+        for (size_t j = 0; j < K; ++j)
+        {
+            const auto& p = powers[K - 1 - j];
+            const auto z1 = p[0][0] * b[0] + p[0][1] * b[1];
+            const auto z2 = p[1][0] * b[0] + p[1][1] * b[1];
+            _z_x[j][0] = std::complex<T>(z1.real(), z1.imag());
+            _z_x[j][1] = std::complex<T>(z2.real(), z2.imag());
+        }
+    }
+
+    // Writes the filter outputs of the K samples in x to y and advances the
+    // state (s1, s2) past them.
+    void process(std::complex<T>& s1, std::complex<T>& s2,
+                 std::span<const T, K> x,
+                 std::span<std::complex<T>, K> y) const
+    {
+        // Outputs, with time in the inner loops so that they vectorize
+        std::array<T, K> re;
+        std::array<T, K> im;
+        for (size_t k = 0; k < K; ++k)
+        {
+            re[k] = _y_s1.re[k] * s1.real() - _y_s1.im[k] * s1.imag() +
+                    _y_s2.re[k] * s2.real() - _y_s2.im[k] * s2.imag();
+            im[k] = _y_s1.re[k] * s1.imag() + _y_s1.im[k] * s1.real() +
+                    _y_s2.re[k] * s2.imag() + _y_s2.im[k] * s2.real();
+        }
+        for (size_t j = 0; j < K; ++j)
+        {
+            for (size_t k = 0; k < K; ++k)
+            {
+                re[k] += _y_x[j].re[k] * x[j];
+                im[k] += _y_x[j].im[k] * x[j];
+            }
+        }
+        for (size_t k = 0; k < K; ++k)
+        {
+            y[k] = {re[k], im[k]};
+        }
+
+        // State
+        auto z1 = _z_z[0][0] * s1 + _z_z[0][1] * s2;
+        auto z2 = _z_z[1][0] * s1 + _z_z[1][1] * s2;
+        for (size_t j = 0; j < K; ++j)
+        {
+            z1 += _z_x[j][0] * x[j];
+            z2 += _z_x[j][1] * x[j];
+        }
+        s1 = z1;
+        s2 = z2;
+    }
+
+private:
+    // One complex coefficient per time step, split for vectorization
+    struct Lanes
+    {
+        std::array<T, K> re{};
+        std::array<T, K> im{};
+    };
+
+    static void set(Lanes& lanes, size_t k, std::complex<double> value)
+    {
+        lanes.re[k] = T(value.real());
+        lanes.im[k] = T(value.imag());
+    }
+
+    Lanes _y_s1;
+    Lanes _y_s2;
+    std::array<Lanes, K> _y_x;
+
+    std::array<std::array<std::complex<T>, 2>, 2> _z_z{};
+    std::array<std::array<std::complex<T>, 2>, K> _z_x{};
+};
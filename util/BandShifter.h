@@ -1,90 +1,306 @@
 #pragma once
 
+#include <algorithm>
+#include <array>
 #include <cmath>
 #include <complex>
-#include <numbers>
+#include <span>
 
+#include <util/BandFilter.h>
 #include <util/FastSqrt.h>
 
+// Bit flags selecting which shifted voices are computed.
+namespace voice
+{
+    constexpr unsigned up1 = 1 << 0;
+    constexpr unsigned down1 = 1 << 1;
+    constexpr unsigned down2 = 1 << 2;
+    constexpr unsigned up2 = 1 << 3;
+    constexpr unsigned down3 = 1 << 4;
+    constexpr unsigned all = up1 | down1 | down2 | up2 | down3;
+
+    // Voices derived from each stage of the octave down recursion
+    constexpr unsigned from_down1 = down1 | down2 | down3;
+    constexpr unsigned from_down2 = down2 | down3;
+}
+
+// Square root implementations for the phase scaling
+struct FastRoots
+{
+    static float invSqrt(float x) { return fastInvSqrt(x); }
+    static float sqrt(float x) { return fastSqrt(x); }
+};
+
+// halfPhase() can pass slightly negative values due to rounding
+struct ExactRoots
+{
+    template <typename T> static T invSqrt(T x) { return 1 / std::sqrt(x); }
+    template <typename T> static T sqrt(T x)
+    {
+        return std::sqrt(std::max(x, T(0)));
+    }
+};
+
 //=============================================================================
-class BandShifter
+// T is the type of the coefficients and state. The firmware uses
+// BandShifter; other instantiations exist to evaluate precision trade-offs.
+template <typename T, typename Roots>
+class BasicBandShifter
 {
 public:
-    BandShifter() = default;
+    BasicBandShifter() = default;
 
-    BandShifter(float center, float sample_rate, float bw)
+    BasicBandShifter(float center, float sample_rate, float bw)
     {
-        constexpr auto pi = std::numbers::pi_v<double>;
-        constexpr auto j = std::complex<double>(0, 1);
+        const BandFilterCoefficients c(center, sample_rate, bw);
+        _d0 = c.d0;
+        _d1 = std::complex<T>(c.d1.real(), c.d1.imag());
+        _d2 = std::complex<T>(c.d2.real(), c.d2.imag());
+        _c1 = std::complex<T>(c.c1.real(), c.c1.imag());
+        _c2 = std::complex<T>(c.c2.real(), c.c2.imag());
+    }
+
+    // Voices missing from the mask are skipped and their outputs are left
+    // stale. The filter and the down1 sign tracking always run.
+    void update(T sample, unsigned voices = voice::all)
+    {
+        update_filter(sample);
+        update_voices(voices, PerSample{});
+    }
 
-        const auto w0 = pi * bw / sample_rate;
-        const auto cos_w0 = std::cos(w0);
-        const auto sin_w0 = std::sin(w0);
-        const auto sqrt_2 = std::sqrt(2.0);
-        const auto a0 = (1 + sqrt_2 * sin_w0 / 2);
-        const auto g = (1 - cos_w0) / (2 * a0);
+    // Same as update(), with the band filter output y computed elsewhere,
+    // e.g. by a filter bank. The filter of this shifter is not used.
+    void updateAnalytic(std::complex<T> y, unsigned voices = voice::all)
+    {
+        set_filter_output(y, PerSample{});
+        update_voices(voices, PerSample{});
+    }
 
-        const auto w1 = 2 * pi * center / sample_rate;
-        const auto e1 = std::exp(j * w1);
-        const auto e2 = std::exp(j * w1 * 2.0);
+    // Same as updateAnalytic(), for a filter output that is only known every
+    // few samples. turns[s] = e^(j a / 2^(s + 1)), where a is the unwrapped
+    // angle by which the phase of y has advanced since the last update, is
+    // the rotation of octave down stage s + 1 in between. The sign flips that
+    // per-sample updates would have detected are inferred from it, so the
+    // voices match those of per-sample updates at the same instants.
+    void updateDecimated(std::complex<T> y,
+                         const std::array<std::complex<T>, 3>& turns,
+                         unsigned voices = voice::all)
+    {
+        const Decimated detector{turns};
+        set_filter_output(y, detector);
+        update_voices(voices, detector);
+    }
 
-        const auto d0 = g;
-        const auto d1 = e1 * 2.0 * g;
-        const auto d2 = e2 * g;
-        const auto c1 = e1 * (-2 * cos_w0) / a0;
-        const auto c2 = e2 * (1 - sqrt_2 * sin_w0 / 2) / a0;
+    // Same as calling update() for each sample, with the filter evaluated in
+    // block state-space form; filter must be built for this band. After
+    // each sample, out(k) is called with its index in the block so that
+    // the caller can read the voices.
+    template <size_t K, typename F>
+    void updateBlock(const BlockBandFilter<T, K>& filter,
+                     std::span<const T, K> samples, unsigned voices, F&& out)
+    {
+        std::array<std::complex<T>, K> y;
+        filter.process(_s1, _s2, samples, y);
 
-        _d0 = d0;
-        _d1 = std::complex<float>(d1.real(), d1.imag());
-        _d2 = std::complex<float>(d2.real(), d2.imag());
-        _c1 = std::complex<float>(c1.real(), c1.imag());
-        _c2 = std::complex<float>(c2.real(), c2.imag());
+        // Sign-flip tracking is serial, so it runs over the finished block
+        for (size_t k = 0; k < K; ++k)
+        {
+            updateAnalytic(y[k], voices);
+            out(k);
+        }
     }
 
-    void update(float sample)
+    // Call before updating with a mask that resumes octave down stages
+    // which were skipped. Recomputes the stages used by the mask from the
+    // current filter output without sign-flip detection, so stale history
+    // cannot cause a spurious flip in the stage below.
+    void resync(unsigned voices)
     {
-        update_filter(sample);
-        update_up1();
-        update_down1();
-        update_down2();
+        const auto inv_mag = invMagnitude();
+
+        if (voices & voice::from_down1)
+        {
+            _down1 = _down1_sign * halfPhase(_y, inv_mag);
+        }
+
+        if (voices & voice::from_down2)
+        {
+            _down2 = _down2_sign * halfPhase(_down1, inv_mag);
+        }
     }
 
-    float up1() const {
-        return _up1;
+    // Negates an octave down stage, voice::down1, down2 or down3, and
+    // recomputes the stages below it that the mask uses. The phase of a
+    // stage is only defined up to its sign, so this is the other valid
+    // choice, e.g. to line up bands that carry the same tone.
+    void invert(unsigned stage, unsigned voices)
+    {
+        const auto inv_mag = invMagnitude();
+
+        if (stage == voice::down1)
+        {
+            _down1_sign = -_down1_sign;
+            _down1 = -_down1;
+            if (voices & voice::from_down2)
+            {
+                _down2 = _down2_sign * halfPhase(_down1, inv_mag);
+            }
+        }
+        else if (stage == voice::down2)
+        {
+            _down2_sign = -_down2_sign;
+            _down2 = -_down2;
+        }
+
+        if (stage == voice::down3)
+        {
+            _down3_sign = -_down3_sign;
+            _down3 = -_down3;
+        }
+        else if (voices & voice::down3)
+        {
+            _down3 = _down3_sign * halfPhase(_down2, inv_mag);
+        }
+    }
+
+    // Takes over the filter and voice state of another band, e.g. the band
+    // with the nearest center frequency in a previous layout, so that a new
+    // band continues the signal instead of starting from silence.
+    void copyState(const BasicBandShifter& other)
+    {
+        _s1 = other._s1;
+        _s2 = other._s2;
+        _y = other._y;
+        _up1 = other._up1;
+        _down1 = other._down1;
+        _down2 = other._down2;
+        _up2 = other._up2;
+        _down3 = other._down3;
+        _down1_sign = other._down1_sign;
+        _down2_sign = other._down2_sign;
+        _down3_sign = other._down3_sign;
+    }
+
+    // Clears the filter and voice state, as if the input had been silent
+    void reset()
+    {
+        _s1 = 0;
+        _s2 = 0;
+        _y = 0;
+        _up1 = 0;
+        _down1 = 0;
+        _down2 = 0;
+        _up2 = 0;
+        _down3 = 0;
+        _down1_sign = 1;
+        _down2_sign = 1;
+        _down3_sign = 1;
+    }
+
+    T up1() const {
+        return _up1.real();
     }
 
-    float down1() {
+    T down1() const {
         return _down1.real();
     }
 
-    float down2() const {
+    T down2() const {
+        return _down2.real();
+    }
+
+    T up2() const {
+        return _up2.real();
+    }
+
+    T down3() const {
+        return _down3.real();
+    }
+
+    // The voices as complex signals, of which the outputs above are the real
+    // parts. Used by banks that shift the voices in frequency (DftBank).
+    std::complex<T> up1Analytic() const {
+        return _up1;
+    }
+
+    std::complex<T> down1Analytic() const {
+        return _down1;
+    }
+
+    std::complex<T> down2Analytic() const {
         return _down2;
     }
 
+    std::complex<T> up2Analytic() const {
+        return _up2;
+    }
+
+    std::complex<T> down3Analytic() const {
+        return _down3;
+    }
+
 private:
-    // Prototype filter is LPF from "Cookbook formulae for audio EQ biquad
-    // filter coefficients", a.k.a. "Audio EQ Cookbook",
-    // by Robert Bristow-Johnson
-    // https://webaudio.github.io/Audio-EQ-Cookbook/audio-eq-cookbook.html
-    //
-    // Transformed as described in Section 3.1 of "Complex Band-Pass Filters
-    // for Analytic Signal Generation and Their Application" by Andrew J. Noga
-    // https://apps.dtic.mil/sti/tr/pdf/ADA395963.pdf
+    // See BandFilterCoefficients for the filter design
+    void update_filter(T sample)
+    {
+        const auto y = _s2 + _d0*sample;
+        _s2 = _s1 + _d1*sample - _c1*y;
+        _s1 = _d2*sample - _c2*y;
+        set_filter_output(y, PerSample{});
+    }
 
-    void update_filter(float sample)
+    template <typename Detector>
+    void set_filter_output(std::complex<T> y, const Detector& wrapped)
     {
         const auto prev_y = _y;
-        _y = _s2 + _d0*sample;
-        _s2 = _s1 + _d1*sample - _c1*_y;
-        _s1 = _d2*sample - _c2*_y;
+        _y = y;
 
-        if ((_y.real() < 0) &&
-            (std::signbit(_y.imag()) != std::signbit(prev_y.imag())))
+        if (wrapped(prev_y, _y, 0))
         {
             _down1_sign = -_down1_sign;
         }
     }
 
+    template <typename Detector>
+    void update_voices(unsigned voices, const Detector& wrapped)
+    {
+        if (!voices)
+        {
+            return;
+        }
+
+        // Every voice has the magnitude of the filter output, so a single
+        // inverse square root serves all of them. The stages are not
+        // renormalized, so with FastRoots the error of each half-phase stage
+        // adds to the next: against double precision exact roots the peak
+        // error is about 0.7% of the amplitude for down1, 1% for down2 and
+        // 1.5% for down3 (-37 dB). Renormalizing every stage lowers down3 to
+        // 1.2% for about 25% more voice cost.
+        const auto inv_mag = invMagnitude();
+
+        if (voices & (voice::up1 | voice::up2))
+        {
+            update_up(inv_mag, voices & voice::up2);
+        }
+
+        // Each octave down stage relies on the sign-flip tracking of the
+        // stage above it
+        if (voices & voice::from_down1)
+        {
+            update_down1(inv_mag, wrapped);
+        }
+
+        if (voices & voice::from_down2)
+        {
+            update_down2(inv_mag, wrapped);
+        }
+
+        if (voices & voice::down3)
+        {
+            update_down3(inv_mag);
+        }
+    }
+
     // Octave shifts are performed via phase scaling described in "Real-Time
     // Polyphonic Octave Doubling for the Guitar" by Etienne Thuillier
     // https://core.ac.uk/download/pdf/80719011.pdf
@@ -98,60 +314,139 @@ private:
     // Note that for octave down (g = 1/2), it is necessary to detect phase
     // transitions in order to set the sign of the output signal.
 
-    void update_up1()
+    // The floor keeps |_y| * invMagnitude() <= 1 when the squared magnitude
+    // underflows (e.g. decaying states with flush-to-zero enabled), which
+    // halfPhase() requires to stay finite.
+    T invMagnitude() const
     {
-        const auto a = _y.real();
-        const auto b = _y.imag();
-        _up1 = (a*a - b*b) * fastInvSqrt(a*a + b*b);
+        return invMagnitude(_y);
     }
 
-    void update_down1()
+    static T invMagnitude(std::complex<T> in)
+    {
+        const auto a = in.real();
+        const auto b = in.imag();
+        return Roots::invSqrt(a*a + b*b + magnitude_floor);
+    }
+
+    // up2 is up1 scaled again by g = 2, which keeps the magnitude of the
+    // input: up2 = up1^2 / |up1|
+    void update_up(T inv_mag, bool up2)
     {
         const auto a = _y.real();
         const auto b = _y.imag();
-        const auto b_sign = (b < 0) ? -1.0f : 1.0f;
+        _up1 = {(a*a - b*b) * inv_mag, 2*a*b * inv_mag};
+
+        if (up2)
+        {
+            const auto c = _up1.real();
+            const auto d = _up1.imag();
+            _up2 = {(c*c - d*d) * inv_mag, 2*c*d * inv_mag};
+        }
+    }
+
+    // Returns in * (in / |in|)^(-1/2), i.e. the phase of in halved, with the
+    // sign ambiguity left to the caller. inv_mag = 1 / |in|
+    static std::complex<T> halfPhase(
+        std::complex<T> in, T inv_mag)
+    {
+        const auto a = in.real();
+        const auto b = in.imag();
+        const auto b_sign = (b < 0) ? T(-1) : T(1);
+
+        const auto x = T(0.5) * a * inv_mag;
+        const auto c = Roots::sqrt(T(0.5) + x);
+        const auto d = b_sign * Roots::sqrt(T(0.5) - x);
+
+        return {(a*c + b*d), (b*c - a*d)};
+    }
+
+    // Sign-flip detection: the phase of a stage wraps when its signal crosses
+    // the negative real axis, and the half-phase stage below must then
+    // change sign to stay continuous.
+    static bool wraps(std::complex<T> prev, std::complex<T> next)
+    {
+        return (next.real() < 0) &&
+            (std::signbit(next.imag()) != std::signbit(prev.imag()));
+    }
 
-        const auto x = 0.5f * a * fastInvSqrt(a*a + b*b);
-        const auto c = fastSqrt(0.5f + x);
-        const auto d = b_sign * fastSqrt(0.5f - x);
+    // Per-sample updates see every wrap directly. For decimated updates, a
+    // stage has wrapped an odd number of times when the half-phase of its
+    // new value points away from that of its previous value advanced by
+    // the rotation of the stage below.
+    struct PerSample
+    {
+        bool operator()(std::complex<T> prev, std::complex<T> next, int) const
+        {
+            return wraps(prev, next);
+        }
+    };
+
+    struct Decimated
+    {
+        const std::array<std::complex<T>, 3>& turns;
+
+        bool operator()(std::complex<T> prev, std::complex<T> next,
+                        int stage) const
+        {
+            const auto expected = halfPhase(prev, invMagnitude(prev)) *
+                turns[stage];
+            const auto actual = halfPhase(next, invMagnitude(next));
+            return (expected.real() * actual.real() +
+                    expected.imag() * actual.imag()) < 0;
+        }
+    };
 
+    template <typename Detector>
+    void update_down1(T inv_mag, const Detector& wrapped)
+    {
         const auto prev_down1 = _down1;
-        _down1 = _down1_sign * std::complex<float>((a*c + b*d), (b*c - a*d));
+        _down1 = _down1_sign * halfPhase(_y, inv_mag);
 
-        if ((_down1.real() < 0) &&
-            (std::signbit(_down1.imag()) != std::signbit(prev_down1.imag())))
+        if (wrapped(prev_down1, _down1, 1))
         {
             _down2_sign = -_down2_sign;
         }
     }
 
-    void update_down2()
+    template <typename Detector>
+    void update_down2(T inv_mag, const Detector& wrapped)
     {
-        const auto a = _down1.real();
-        const auto b = _down1.imag();
-        const auto b_sign = (b < 0) ? -1.0f : 1.0f;
+        const auto prev_down2 = _down2;
+        _down2 = _down2_sign * halfPhase(_down1, inv_mag);
 
-        const auto x = 0.5f * a * fastInvSqrt(a*a + b*b);
-        const auto c = fastSqrt(0.5f + x);
-        const auto d = b_sign * fastSqrt(0.5f - x);
+        if (wrapped(prev_down2, _down2, 2))
+        {
+            _down3_sign = -_down3_sign;
+        }
+    }
 
-        _down2 = _down2_sign * (a*c + b*d);
+    void update_down3(T inv_mag)
+    {
+        _down3 = _down3_sign * halfPhase(_down2, inv_mag);
     }
 
-    float _d0 = 0;
-    std::complex<float> _d1;
-    std::complex<float> _d2;
-    std::complex<float> _c1;
-    std::complex<float> _c2;
+    static constexpr T magnitude_floor = T(1e-30);
+
+    T _d0 = 0;
+    std::complex<T> _d1;
+    std::complex<T> _d2;
+    std::complex<T> _c1;
+    std::complex<T> _c2;
 
-    std::complex<float> _s1;
-    std::complex<float> _s2;
+    std::complex<T> _s1;
+    std::complex<T> _s2;
 
-    std::complex<float> _y;
-    float _up1 = 0;
-    std::complex<float> _down1;
-    float _down2 = 0;
+    std::complex<T> _y;
+    std::complex<T> _up1;
+    std::complex<T> _down1;
+    std::complex<T> _down2;
+    std::complex<T> _up2;
+    std::complex<T> _down3;
 
-    float _down1_sign = 1;
-    float _down2_sign = 1;
+    T _down1_sign = 1;
+    T _down2_sign = 1;
+    T _down3_sign = 1;
 };
+
+using BandShifter = BasicBandShifter<float, FastRoots>;
@@ -0,0 +1,178 @@
+#include "DaisyTerrarium.h"
+
+#include <type_traits>
+
+// Lets the firmware callback be handed directly to libDaisy
+static_assert(std::is_same_v<
+    Terrarium::AudioCallback, daisy::AudioHandle::AudioCallback>);
+
+void DaisyTerrarium::Init(bool boost)
+{
+    seed.Init(boost);
+    InitKnobs();
+    InitToggles();
+    InitStomps();
+    InitLeds();
+}
+
+float DaisyTerrarium::AudioSampleRate()
+{
+    return seed.AudioSampleRate();
+}
+
+size_t DaisyTerrarium::AudioBlockSize()
+{
+    return seed.AudioBlockSize();
+}
+
+void DaisyTerrarium::StartAudio(AudioCallback callback)
+{
+    seed.StartAudio(callback);
+}
+
+void DaisyTerrarium::Loop(float frequency, std::function<void()> callback)
+{
+    for (auto& knob : knobs)
+    {
+        knob.SetSampleRate(frequency);
+    }
+
+    daisy::TimerHandle::Config config;
+    config.periph = daisy::TimerHandle::Config::Peripheral::TIM_5;
+    config.dir = daisy::TimerHandle::Config::CounterDir::UP;
+    config.enable_irq = true;
+    _loop_timer.Init(config);
+    _loop_timer.SetPeriod(
+        static_cast<uint32_t>(_loop_timer.GetFreq() / frequency) - 1);
+    _loop_timer.SetCallback(OnLoopTimer, this);
+    _loop_timer.Start();
+
+    uint32_t handled_ticks = _loop_ticks;
+    while (true)
+    {
+        for (auto& toggle : toggles)
+        {
+            toggle.Debounce();
+        }
+
+        for (auto& stomp : stomps)
+        {
+            stomp.Debounce();
+        }
+
+        callback();
+
+        // Sleep until the next timer period has elapsed. Ticks that elapsed
+        // during an overlong callback are caught up without sleeping, as
+        // with the previous tick-counting loop.
+        while (_loop_ticks == handled_ticks)
+        {
+            __WFI();
+        }
+        ++handled_ticks;
+    }
+}
+
+void DaisyTerrarium::OnLoopTimer(void* data)
+{
+    auto& self = *static_cast<DaisyTerrarium*>(data);
+    self._loop_ticks = self._loop_ticks + 1;
+}
+
+float DaisyTerrarium::ProcessKnob(int index)
+{
+    return knobs[index].Process();
+}
+
+bool DaisyTerrarium::StompRisingEdge(int index)
+{
+    return stomps[index].RisingEdge();
+}
+
+bool DaisyTerrarium::ToggleOn(int index)
+{
+    return toggles[index].Pressed();
+}
+
+void DaisyTerrarium::SetLed(int index, float brightness)
+{
+    leds[index].Set(brightness);
+}
+
+uint32_t DaisyTerrarium::TimerTicks()
+{
+    return daisy::System::GetTick();
+}
+
+float DaisyTerrarium::TimerTickRate()
+{
+    return daisy::System::GetTickFreq();
+}
+
+void DaisyTerrarium::InitKnobs()
+{
+    constexpr std::array<daisy::Pin, knob_count> knob_pins{
+        daisy::seed::A1,
+        daisy::seed::A2,
+        daisy::seed::A3,
+        daisy::seed::A4,
+        daisy::seed::A5,
+        daisy::seed::A6,
+    };
+
+    std::array<daisy::AdcChannelConfig, knob_count> adc_configs;
+    for (int i = 0; i < knob_count; ++i)
+    {
+        adc_configs[i].InitSingle(knob_pins[i]);
+    }
+
+    seed.adc.Init(adc_configs.data(), adc_configs.size());
+    seed.adc.Start();
+
+    const auto poll_rate = seed.AudioCallbackRate();
+    for (int i = 0; i < knob_count; ++i)
+    {
+        knobs[i].Init(seed.adc.GetPtr(i), poll_rate);
+    }
+}
+
+void DaisyTerrarium::InitToggles()
+{
+    constexpr std::array<daisy::Pin, toggle_count> toggle_pins{
+        daisy::seed::D10,
+        daisy::seed::D9,
+        daisy::seed::D8,
+        daisy::seed::D7,
+    };
+
+    for (int i = 0; i < toggle_count; ++i)
+    {
+        toggles[i].Init(toggle_pins[i]);
+    }
+}
+
+void DaisyTerrarium::InitStomps()
+{
+    constexpr std::array<daisy::Pin, stomp_count> stomp_pins{
+        daisy::seed::D25,
+        daisy::seed::D26,
+    };
+
+    for (int i = 0; i < stomp_count; ++i)
+    {
+        stomps[i].Init(stomp_pins[i]);
+    }
+}
+
+void DaisyTerrarium::InitLeds()
+{
+    constexpr std::array<daisy::DacHandle::Channel, led_count> led_dacs{
+        daisy::DacHandle::Channel::TWO,
+        daisy::DacHandle::Channel::ONE,
+    };
+
+    for (int i = 0; i < led_count; ++i)
+    {
+        leds[i].Init(led_dacs[i]);
+    }
+}
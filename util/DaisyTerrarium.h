@@ -0,0 +1,54 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <functional>
+
+#include <daisy_seed.h>
+
+#include <util/Led.h>
+#include <util/Terrarium.h>
+
+class DaisyTerrarium : public Terrarium
+{
+public:
+    // Initializes the Daisy Seed hardware and the Terrarium interface.
+    // Call this method before using other members of this class.
+    void Init(bool boost = false) override;
+
+    float AudioSampleRate() override;
+    size_t AudioBlockSize() override;
+    void StartAudio(AudioCallback callback) override;
+
+    // Start an infinite loop that executes at the given frequency in hertz.
+    // Sets the Terrarium knob sample rates to match the loop frequency.
+    // Automatically debounces the Terrarium toggle and stomp switches.
+    // Iterations are paced by a hardware timer; the core sleeps in between.
+    void Loop(float frequency, std::function<void()> callback) override;
+
+    float ProcessKnob(int index) override;
+    bool StompRisingEdge(int index) override;
+    bool ToggleOn(int index) override;
+    void SetLed(int index, float brightness) override;
+    uint32_t TimerTicks() override;
+    float TimerTickRate() override;
+
+    daisy::DaisySeed seed;
+
+    std::array<daisy::AnalogControl, knob_count> knobs;
+    std::array<daisy::Switch, toggle_count> toggles;
+    std::array<daisy::Switch, stomp_count> stomps;
+    std::array<Led, led_count> leds;
+
+private:
+    void InitKnobs();
+    void InitToggles();
+    void InitStomps();
+    void InitLeds();
+
+    static void OnLoopTimer(void* data);
+
+    daisy::TimerHandle _loop_timer;
+    // Written only by the timer interrupt
+    volatile uint32_t _loop_ticks = 0;
+};
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstdint>
+
+#if defined(__arm__)
+#include <stm32h7xx.h>
+#elif defined(__x86_64__) || defined(__SSE__)
+#include <xmmintrin.h>
+#endif
+
+// The recursive filter states (band filters, shelving EQs, resampler
+// histories) decay toward zero after a note ends and eventually reach the
+// subnormal range, where some FPUs fall back to much slower arithmetic.
+// Flushing subnormals to zero keeps the cost of silence equal to the cost of
+// signal.
+//
+// Call on the thread that runs the audio callback. On the device this also
+// sets the default FPSCR loaded on exception entry, so it covers the audio
+// interrupt as well as the calling thread.
+inline void enableFlushToZero()
+{
+#if defined(__arm__)
+    constexpr uint32_t fpscr_fz = 1 << 24;
+    __set_FPSCR(__get_FPSCR() | fpscr_fz);
+    FPU->FPDSCR |= FPU_FPDSCR_FZ_Msk;
+#elif defined(__x86_64__) || defined(__SSE__)
+    constexpr unsigned int mxcsr_ftz = 1 << 15;
+    constexpr unsigned int mxcsr_daz = 1 << 6;
+    _mm_setcsr(_mm_getcsr() | mxcsr_ftz | mxcsr_daz);
+#elif defined(__aarch64__)
+    constexpr uint64_t fpcr_fz = 1 << 24;
+    uint64_t fpcr;
+    asm volatile("mrs %0, fpcr" : "=r"(fpcr));
+    asm volatile("msr fpcr, %0" : : "r"(fpcr | fpcr_fz));
+#endif
+}
@@ -0,0 +1,614 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <complex>
+#include <numbers>
+#include <vector>
+
+#include <util/BandBank.h>
+#include <util/BandShifter.h>
+#include <util/Fft.h>
+
+//=============================================================================
+// Band bank based on an oversampled polyphase DFT filter bank. All channels
+// are modulated copies of one linear-phase low-pass prototype, and they are
+// evaluated once per hop of size / oversampling samples: one pass over the
+// prototype and one FFT give all channels, i.e. O(log size) per channel and
+// hop.
+//
+// The BandShifters run at the hop rate. The phase a channel turns over a
+// hop is its turn at the channel frequency plus that of its baseband, so
+// the octave down stages flip sign as they would per sample. Neighboring
+// channels that carry the same tone share the signs of the stronger one;
+// see alignPair(). Each voice, scaling the phase by g, is shifted down to
+// baseband by g times the channel frequency, interpolated linearly between
+// hops and shifted back up. That costs a complex multiply-add per channel,
+// voice and sample. The shifters are updated a slice of channels per sample
+// to spread the load over the hop.
+//
+// Channels are uniformly spaced at sample_rate / size, with size a power of
+// two. The layout maps onto the bank as follows: the spacing is the finest
+// that is not finer than the mean spacing of band_count bands, and the bank
+// has a channel at each multiple of it from min_freq to max_freq, at most
+// band_count channels. bandwidth_scale scales the cutoff of the prototype;
+// at 1 the channels sum to a delayed copy of the input. The exponential
+// curve of BandLayout does not apply.
+//
+// Every channel is delayed by size samples, the group delay of the
+// prototype, and the voices by another two hops.
+template <typename T, typename Roots>
+struct DftBank
+{
+    using Sample = T;
+    using Shifter = BasicBandShifter<T, Roots>;
+
+    // Prototype length in multiples of the size. Longer prototypes leak less
+    // into neighboring channels but add delay.
+    static constexpr size_t taps_per_phase = 2;
+
+    // Channel rate relative to the channel spacing. The baseband voices must
+    // change little over a hop for the interpolation: a tone between two
+    // channels turns up2 by 2 pi / 8 per hop.
+    static constexpr size_t oversampling = 16;
+
+    void resize(const BandLayout& layout, float sample_rate)
+    {
+        const auto max_spacing = (layout.max_freq - layout.min_freq) /
+            std::max(layout.band_count - 1, 1);
+
+        size_t size = oversampling;
+        while (sample_rate / (2 * size) >= max_spacing)
+        {
+            size *= 2;
+        }
+        const auto spacing = sample_rate / size;
+        const auto first = std::clamp<long>(
+            std::lround(layout.min_freq / spacing), 1, long(size / 2) - 1);
+        const auto last = std::clamp<long>(
+            std::lround(layout.max_freq / spacing), first, long(size / 2) - 1);
+        const auto count = std::min<size_t>(
+            last - first + 1, std::max(layout.band_count, 1));
+
+        _size = size;
+        _hop = size / oversampling;
+        _first_channel = size_t(first);
+        _phase = 0;
+        _frame = 0;
+        _synthesized = 0;
+
+        // Windowed sinc with zeros at multiples of size from its center,
+        // which makes the sum of all channels a pure delay
+        constexpr auto pi = std::numbers::pi_v<double>;
+        const auto length = taps_per_phase * size;
+        const auto center = double(length / 2);
+        _prototype.resize(length);
+        double sum = 0;
+        for (size_t m = 0; m < length; ++m)
+        {
+            const auto t = layout.bandwidth_scale * (m - center) / size;
+            const auto sinc = (t == 0) ? 1.0 : std::sin(pi * t) / (pi * t);
+            const auto window = 0.5 - 0.5 * std::cos(2 * pi * m / length);
+            _prototype[m] = T(sinc * window);
+            sum += sinc * window;
+        }
+        for (auto& h : _prototype)
+        {
+            h = T(h / sum);
+        }
+
+        _history.assign(2 * length, T(0));
+        _position = 0;
+        _folded.resize(size);
+        _packed.resize(size / 2);
+        _fft = Fft<T>(size / 2, 1);
+
+        _rotations.resize(count);
+        _channels.assign(count, 0);
+        _baseband.assign(count, 0);
+        _coherence.assign(count, 0);
+        for (size_t i = 0; i < count; ++i)
+        {
+            const auto w = std::polar(
+                1.0, 2 * pi * double(_first_channel + i) / size);
+            _rotations[i] = std::complex<T>(w.real(), w.imag());
+        }
+
+        // e^(j 2 pi i / (8 size)), the phases of the baseband shift and of
+        // the carriers
+        _unit_circle.resize(8 * size);
+        for (size_t i = 0; i < _unit_circle.size(); ++i)
+        {
+            const auto w = std::polar(
+                1.0, 2 * pi * double(i) / _unit_circle.size());
+            _unit_circle[i] = std::complex<T>(w.real(), w.imag());
+        }
+
+        for (size_t v = 0; v < voice_count; ++v)
+        {
+            _synthesis[v].resize(count, _first_channel, size, ratios[v]);
+        }
+
+        shifters.resize(count);
+        centers.resize(count);
+        bandwidths.resize(count);
+    }
+
+    void build(const BandLayout& layout, float sample_rate,
+               int begin, int end)
+    {
+        const auto spacing = sample_rate / _size;
+        for (int i = begin; i < end; ++i)
+        {
+            centers[i] = (_first_channel + i) * spacing;
+            bandwidths[i] = layout.bandwidth_scale * spacing;
+            shifters[i] = Shifter();
+        }
+    }
+
+    // Continues from the input history of the old bank, so the channels are
+    // valid right away. With the same channel spacing the voices continue
+    // too; otherwise they fade in over two hops.
+    void carryStateFrom(const DftBank& old)
+    {
+        const auto length = _prototype.size();
+        const auto old_length = old._prototype.size();
+        if (old_length > 0)
+        {
+            const auto* old_input = &old._history[old._position];
+            _position = 0;
+            for (size_t m = 0; m < std::min(length, old_length); ++m)
+            {
+                _history[m] = _history[m + length] = old_input[m];
+            }
+        }
+
+        if (old._size == _size)
+        {
+            _phase = old._phase;
+            _frame = old._frame;
+            _channel_time = old._channel_time;
+            _synthesized = shifters.size();
+            for (size_t i = 0; i < shifters.size(); ++i)
+            {
+                const auto j = long(_first_channel + i) -
+                    long(old._first_channel);
+                if ((j >= 0) && (j < long(old._synthesized)))
+                {
+                    _channels[i] = old._channels[j];
+                    _baseband[i] = old._baseband[j];
+                    _coherence[i] = old._coherence[j];
+                    for (size_t v = 0; v < voice_count; ++v)
+                    {
+                        _synthesis[v].copy(i, old._synthesis[v], j);
+                    }
+                }
+            }
+        }
+
+        carryShifterState(*this, old);
+    }
+
+    VoiceMix<T> update(T sample, int band_count, unsigned voices)
+    {
+        const auto count = size_t(band_count);
+
+        // History in a buffer of twice its length, written twice, so that
+        // input[m] is the input m samples ago without wrapping
+        const auto length = _prototype.size();
+        _position = ((_position == 0) ? length : _position) - 1;
+        _history[_position] = _history[_position + length] = sample;
+
+        // Shed channels that resume start from silence
+        if (count > _synthesized)
+        {
+            std::fill(_baseband.begin() + _synthesized,
+                      _baseband.begin() + count, 0);
+            for (auto& synthesis : _synthesis)
+            {
+                synthesis.clear(_synthesized, count);
+            }
+        }
+        _synthesized = count;
+
+        if (_phase == 0)
+        {
+            startHop(count, voices);
+        }
+
+        // The shifters of a slice of channels, producing the baseband
+        // voices that the next hop interpolates towards. The slices cover
+        // all channels, so that they stay the same when shedding changes
+        // count mid-hop: otherwise a channel could be updated twice in a
+        // hop, with its sign flips counted for two hops.
+        const auto slice = (shifters.size() + _hop - 1) / _hop;
+        const auto end = std::min(count, (_phase + 1) * slice);
+        for (size_t i = _phase * slice; i < end; ++i)
+        {
+            updateShifter(i, voices);
+        }
+        _phase = (_phase + 1 == _hop) ? 0 : _phase + 1;
+
+        VoiceMix<T> mix;
+        if (voices & voice::up1)
+        {
+            mix.up1 = _synthesis[0].next(count);
+        }
+        if (voices & voice::down1)
+        {
+            mix.down1 = _synthesis[1].next(count);
+        }
+        if (voices & voice::down2)
+        {
+            mix.down2 = _synthesis[2].next(count);
+        }
+        if (voices & voice::up2)
+        {
+            mix.up2 = _synthesis[3].next(count);
+        }
+        if (voices & voice::down3)
+        {
+            mix.down3 = _synthesis[4].next(count);
+        }
+        return mix;
+    }
+
+    std::vector<Shifter> shifters;
+    std::vector<float> centers;
+    std::vector<float> bandwidths;
+
+private:
+    // Voices in the order of their bits in the voice mask, and the factor
+    // by which each scales the frequency
+    static constexpr size_t voice_count = 5;
+    static constexpr std::array<double, voice_count> ratios{
+        2, 0.5, 0.25, 4, 0.125};
+
+    // Per hop, and the mean phase agreement above which two channels are
+    // taken to carry the same tone
+    static constexpr T coherence_smoothing = T(0.125);
+    static constexpr T coherence_threshold = T(0.9);
+
+    // One voice of all channels. Its baseband value moves linearly towards
+    // the target over a hop and is multiplied by a carrier at g times the
+    // channel frequency, in real arithmetic so that the loops vectorize.
+    struct Synthesis
+    {
+        void resize(size_t count, size_t first, size_t size, double ratio)
+        {
+            for (auto* v : {&target_re, &target_im, &value_re, &value_im,
+                            &delta_re, &delta_im, &carrier_re, &carrier_im,
+                            &step_re, &step_im})
+            {
+                v->assign(count, T(0));
+            }
+
+            // Carrier phases are exact multiples of 2 pi / (8 size)
+            constexpr auto pi = std::numbers::pi_v<double>;
+            units_per_channel = size_t(std::lround(8 * ratio));
+            for (size_t i = 0; i < count; ++i)
+            {
+                const auto w = std::polar(
+                    1.0, 2 * pi * ratio * double(first + i) / size);
+                step_re[i] = T(w.real());
+                step_im[i] = T(w.imag());
+            }
+        }
+
+        void clear(size_t begin, size_t end)
+        {
+            for (auto* v : {&target_re, &target_im, &value_re, &value_im,
+                            &delta_re, &delta_im})
+            {
+                std::fill(v->begin() + begin, v->begin() + end, T(0));
+            }
+        }
+
+        void copy(size_t i, const Synthesis& other, size_t j)
+        {
+            target_re[i] = other.target_re[j];
+            target_im[i] = other.target_im[j];
+            value_re[i] = other.value_re[j];
+            value_im[i] = other.value_im[j];
+            delta_re[i] = other.delta_re[j];
+            delta_im[i] = other.delta_im[j];
+            carrier_re[i] = other.carrier_re[j];
+            carrier_im[i] = other.carrier_im[j];
+        }
+
+        void setTarget(size_t i, std::complex<T> value)
+        {
+            target_re[i] = value.real();
+            target_im[i] = value.imag();
+        }
+
+        // Starts interpolating towards the targets. The carriers restart
+        // from their exact phase at sample time n, in multiples of
+        // 2 pi / (8 size): 8 g k n for channel k.
+        void startHop(size_t count, size_t hop, size_t first, size_t n,
+                      const std::vector<std::complex<T>>& unit_circle)
+        {
+            const auto mask = unit_circle.size() - 1;
+            auto units = first * n * units_per_channel;
+            const auto units_step = n * units_per_channel;
+            const auto scale = T(1) / hop;
+            for (size_t i = 0; i < count; ++i)
+            {
+                delta_re[i] = (target_re[i] - value_re[i]) * scale;
+                delta_im[i] = (target_im[i] - value_im[i]) * scale;
+                const auto c = unit_circle[units & mask];
+                carrier_re[i] = c.real();
+                carrier_im[i] = c.imag();
+                units += units_step;
+            }
+        }
+
+        // Returns the real part of the voice summed over the channels and
+        // advances by one sample
+        T next(size_t count)
+        {
+            T sum = 0;
+            for (size_t i = 0; i < count; ++i)
+            {
+                sum += value_re[i] * carrier_re[i] -
+                       value_im[i] * carrier_im[i];
+                value_re[i] += delta_re[i];
+                value_im[i] += delta_im[i];
+                const auto re = carrier_re[i] * step_re[i] -
+                                carrier_im[i] * step_im[i];
+                carrier_im[i] = carrier_re[i] * step_im[i] +
+                                carrier_im[i] * step_re[i];
+                carrier_re[i] = re;
+            }
+            return sum;
+        }
+
+        size_t units_per_channel = 0;
+        std::vector<T> target_re, target_im;
+        std::vector<T> value_re, value_im;
+        std::vector<T> delta_re, delta_im;
+        std::vector<T> carrier_re, carrier_im;
+        std::vector<T> step_re, step_im;
+    };
+
+    // Updates the shifter of channel i with its output at the last hop and
+    // sets the baseband targets of its voices
+    void updateShifter(size_t i, unsigned voices)
+    {
+        const auto mask = _unit_circle.size() - 1;
+        const auto k = _first_channel + i;
+        const auto y = _channels[i];
+
+        // The channel turns by 2 pi k hop / size, 8 k hop units, plus the
+        // turn of its baseband, which is less than pi per hop near a tone.
+        // The octave down stages turn by a half, a quarter and an eighth.
+        const auto baseband =
+            y * std::conj(_unit_circle[(8 * k * _channel_time) & mask]);
+        auto beat = baseband * std::conj(_baseband[i]);
+        beat *= Roots::invSqrt(std::norm(beat) + T(1e-30));
+        _baseband[i] = baseband;
+
+        std::array<std::complex<T>, 3> turns;
+        for (size_t s = 0; s < turns.size(); ++s)
+        {
+            beat = halfTurn(beat);
+            const auto units = (4 * k * _hop) >> s;
+            turns[s] = beat * _unit_circle[units & mask];
+        }
+
+        shifters[i].updateDecimated(y, turns, voices);
+
+        // Aligning may change the channel below, whose targets are set
+        if ((i > 0) && alignPair(i, voices))
+        {
+            setTargets(i - 1, voices);
+        }
+        setTargets(i, voices);
+    }
+
+    // Voice v is at g times the channel frequency, 8 g k n units. The shift
+    // to baseband also takes 8 g k size units off its phase: channel k
+    // turns by 2 pi k more than the input over the delay of size samples,
+    // which scaled by g would offset the voice by 2 pi g k. Adjacent
+    // channels carrying the same tone would then cancel in down1 and partly
+    // in down2 and down3.
+    void setTargets(size_t i, unsigned voices)
+    {
+        const auto mask = _unit_circle.size() - 1;
+        const auto k = _first_channel + i;
+        const auto shift_time = (_channel_time + _size) % (8 * _size);
+        const auto& shifter = shifters[i];
+        const auto set_target = [&](size_t v, std::complex<T> value)
+        {
+            const auto units =
+                _synthesis[v].units_per_channel * k * shift_time;
+            _synthesis[v].setTarget(
+                i, value * std::conj(_unit_circle[units & mask]));
+        };
+        if (voices & voice::up1)
+        {
+            set_target(0, shifter.up1Analytic());
+        }
+        if (voices & voice::down1)
+        {
+            set_target(1, shifter.down1Analytic());
+        }
+        if (voices & voice::down2)
+        {
+            set_target(2, shifter.down2Analytic());
+        }
+        if (voices & voice::up2)
+        {
+            set_target(3, shifter.up2Analytic());
+        }
+        if (voices & voice::down3)
+        {
+            set_target(4, shifter.down3Analytic());
+        }
+    }
+
+    // The prototype is linear phase, so channels that carry the same tone
+    // are in phase, and so must be their voices or they cancel. Their octave
+    // down stages may however have settled on opposite signs: for a tone
+    // between two channels, one of them turns by 2 pi more than the other
+    // over the delay of the prototype, and which one depends on how the tone
+    // started. When channel i stays in phase with channel i - 1 over several
+    // hops, the weaker of the two takes over the signs of the stronger, so
+    // that the signs spread out from the strongest channel of each tone.
+    // Returns true when channel i - 1 was changed.
+    bool alignPair(size_t i, unsigned voices)
+    {
+        auto pair = _channels[i] * std::conj(_channels[i - 1]);
+        pair *= Roots::invSqrt(std::norm(pair) + T(1e-30));
+        _coherence[i] += coherence_smoothing * (pair - _coherence[i]);
+        if (_coherence[i].real() < coherence_threshold)
+        {
+            return false;
+        }
+
+        const auto lower_weaker =
+            std::norm(_channels[i - 1]) < std::norm(_channels[i]);
+        auto& weaker = shifters[lower_weaker ? i - 1 : i];
+        const auto& stronger = shifters[lower_weaker ? i : i - 1];
+
+        // Voice g of channel k is compared after taking off 2 pi g k, see
+        // setTargets(): 2 pi g more for the upper channel of the pair
+        bool changed = false;
+        const auto align = [&](unsigned stage, std::complex<T> a,
+                               std::complex<T> b, size_t units)
+        {
+            const auto offset = _unit_circle[units];
+            const auto c = lower_weaker ?
+                a * offset * std::conj(b) : a * std::conj(b * offset);
+            if (c.real() < 0)
+            {
+                weaker.invert(stage, voices);
+                changed = true;
+            }
+        };
+        const auto quarter = _unit_circle.size() / 4;
+        if (voices & voice::from_down1)
+        {
+            align(voice::down1, weaker.down1Analytic(),
+                  stronger.down1Analytic(), 2 * quarter);
+        }
+        if (voices & voice::from_down2)
+        {
+            align(voice::down2, weaker.down2Analytic(),
+                  stronger.down2Analytic(), quarter);
+        }
+        if (voices & voice::down3)
+        {
+            align(voice::down3, weaker.down3Analytic(),
+                  stronger.down3Analytic(), quarter / 2);
+        }
+        return changed && lower_weaker;
+    }
+
+    // Halves the angle of a unit vector in (-pi, pi]
+    static std::complex<T> halfTurn(std::complex<T> w)
+    {
+        const auto sign = (w.imag() < 0) ? T(-1) : T(1);
+        return {Roots::sqrt(T(0.5) + T(0.5) * w.real()),
+                sign * Roots::sqrt(T(0.5) - T(0.5) * w.real())};
+    }
+
+    // Evaluates the channels at the current sample and starts the
+    // interpolation of the voices of the previous hop
+    void startHop(size_t count, unsigned voices)
+    {
+        // Phases repeat after 8 size samples, i.e. 8 oversampling hops
+        constexpr auto frames = 8 * oversampling;
+        const auto* input = &_history[_position];
+
+        // Polyphase components u[r] = sum_p h[r + p size] x[n - r - p size]
+        std::fill(_folded.begin(), _folded.end(), T(0));
+        for (size_t p = 0; p < taps_per_phase; ++p)
+        {
+            const auto* h = &_prototype[p * _size];
+            const auto* x = &input[p * _size];
+            for (size_t r = 0; r < _size; ++r)
+            {
+                _folded[r] += h[r] * x[r];
+            }
+        }
+
+        // Channel k = sum_r u[r] e^(j 2 pi k r / size), from one FFT of half
+        // the size with the even and odd components packed as complex
+        for (size_t r = 0; r < _packed.size(); ++r)
+        {
+            _packed[r] = {_folded[2*r], _folded[2*r + 1]};
+        }
+        _fft(_packed);
+
+        // All channels are evaluated so that shed channels resume cleanly
+        const auto half = _packed.size();
+        for (size_t i = 0; i < shifters.size(); ++i)
+        {
+            const auto k = _first_channel + i;
+            // Even and odd parts: e = (z1 + z2*) / 2, o = (z1 - z2*) / 2j
+            const auto z1 = _packed[k];
+            const auto z2 = _packed[half - k];
+            const auto even_re = T(0.5) * (z1.real() + z2.real());
+            const auto even_im = T(0.5) * (z1.imag() - z2.imag());
+            const auto odd_re = T(0.5) * (z1.imag() + z2.imag());
+            const auto odd_im = T(0.5) * (z2.real() - z1.real());
+
+            // Channel = e + w o
+            const auto w = _rotations[i];
+            _channels[i] = {
+                even_re + w.real() * odd_re - w.imag() * odd_im,
+                even_im + w.real() * odd_im + w.imag() * odd_re};
+        }
+        _channel_time = _frame * _hop;
+
+        // The voices interpolated over this hop are those of the channels
+        // two hops ago, so their carriers continue from that time
+        const auto delayed = ((_frame + frames - 2) % frames) * _hop;
+        for (size_t v = 0; v < voice_count; ++v)
+        {
+            if (voices & (1u << v))
+            {
+                _synthesis[v].startHop(count, _hop, _first_channel, delayed,
+                                       _unit_circle);
+            }
+            else
+            {
+                _synthesis[v].clear(0, count);
+            }
+        }
+
+        _frame = (_frame + 1) % frames;
+    }
+
+    size_t _size = 0;
+    size_t _hop = 1;
+    size_t _first_channel = 0;
+    std::vector<T> _prototype;
+    std::vector<T> _history;
+    size_t _position = 0;
+
+    std::vector<T> _folded;
+    std::vector<std::complex<T>> _packed;
+    Fft<T> _fft;
+    // e^(j 2 pi k / size) for each channel k in use
+    std::vector<std::complex<T>> _rotations;
+
+    // Position within the hop, and hops since the phases last repeated
+    size_t _phase = 0;
+    size_t _frame = 0;
+
+    // Channel outputs at sample time _channel_time, and the baseband of
+    // each at the hop before it was last passed to its shifter
+    std::vector<std::complex<T>> _channels;
+    size_t _channel_time = 0;
+    std::vector<std::complex<T>> _baseband;
+
+    // Phase agreement of each channel with the one below, averaged over hops
+    std::vector<std::complex<T>> _coherence;
+    std::array<Synthesis, voice_count> _synthesis;
+    std::vector<std::complex<T>> _unit_circle;
+    // Channels whose voices are up to date
+    size_t _synthesized = 0;
+};
@@ -9,11 +9,15 @@ public:
     void setUp1Ratio(float r) { _up1_ratio = r; }
     void setDown1Ratio(float r) { _down1_ratio = r; }
     void setDown2Ratio(float r) { _down2_ratio = r; }
+    void setUp2Ratio(float r) { _up2_ratio = r; }
+    void setDown3Ratio(float r) { _down3_ratio = r; }
 
     float dryLevel() const { return volume_mapping(_dry_ratio); }
     float up1Level() const { return volume_mapping(_up1_ratio); }
     float down1Level() const { return volume_mapping(_down1_ratio); }
     float down2Level() const { return volume_mapping(_down2_ratio); }
+    float up2Level() const { return volume_mapping(_up2_ratio); }
+    float down3Level() const { return volume_mapping(_down3_ratio); }
 
 private:
     static constexpr LogMapping volume_mapping{0, 1, 20};
@@ -25,4 +29,6 @@ private:
     float _up1_ratio = ratio_min;
     float _down1_ratio = ratio_min;
     float _down2_ratio = ratio_min;
+    float _up2_ratio = ratio_min;
+    float _down3_ratio = ratio_min;
 };
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <complex>
+#include <cstddef>
+#include <numbers>
+#include <span>
+#include <utility>
+#include <vector>
+
+//=============================================================================
+// In-place radix-2 FFT of a fixed power of two size, unnormalized:
+//
+//   X[k] = sum_n x[n] e^(sign j 2 pi k n / size)
+//
+// sign = -1 is the forward transform, sign = 1 the inverse without the
+// 1/size factor. Tables are computed on construction; transforms do not
+// allocate.
+template <typename T>
+class Fft
+{
+public:
+    Fft() = default;
+
+    explicit Fft(size_t size, int sign = -1) :
+        _size(size),
+        _bit_reverse(size),
+        _twiddles(size / 2)
+    {
+        size_t bits = 0;
+        while ((size_t(1) << bits) < size)
+        {
+            ++bits;
+        }
+
+        for (size_t i = 0; i < size; ++i)
+        {
+            size_t r = 0;
+            for (size_t b = 0; b < bits; ++b)
+            {
+                r |= ((i >> b) & 1) << (bits - 1 - b);
+            }
+            _bit_reverse[i] = r;
+        }
+
+        constexpr auto pi = std::numbers::pi_v<double>;
+        for (size_t k = 0; k < size / 2; ++k)
+        {
+            const auto w = std::polar(1.0, sign * 2 * pi * k / size);
+            _twiddles[k] = std::complex<T>(w.real(), w.imag());
+        }
+    }
+
+    size_t size() const
+    {
+        return _size;
+    }
+
+    void operator()(std::span<std::complex<T>> x) const
+    {
+        for (size_t i = 0; i < _size; ++i)
+        {
+            const auto r = _bit_reverse[i];
+            if (i < r)
+            {
+                std::swap(x[i], x[r]);
+            }
+        }
+
+        // Butterflies are written out in real arithmetic, which avoids the
+        // special value handling of std::complex multiplication
+        auto* data = reinterpret_cast<T*>(x.data());
+        for (size_t half = 1; half < _size; half *= 2)
+        {
+            const auto stride = _size / (2 * half);
+            for (size_t k = 0; k < half; ++k)
+            {
+                const auto wr = _twiddles[k * stride].real();
+                const auto wi = _twiddles[k * stride].imag();
+                for (size_t a = 2 * k; a < 2 * _size; a += 4 * half)
+                {
+                    const auto b = a + 2 * half;
+                    const auto br = data[b] * wr - data[b+1] * wi;
+                    const auto bi = data[b] * wi + data[b+1] * wr;
+                    data[b] = data[a] - br;
+                    data[b+1] = data[a+1] - bi;
+                    data[a] += br;
+                    data[a+1] += bi;
+                }
+            }
+        }
+    }
+
+private:
+    size_t _size = 0;
+    std::vector<size_t> _bit_reverse;
+    std::vector<std::complex<T>> _twiddles;
+};
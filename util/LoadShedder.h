@@ -0,0 +1,82 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+
+//=============================================================================
+// Decides how much work the audio callback should shed to stay within its
+// deadline. Feed it the load of every block, i.e. the time the callback took
+// divided by the block period. Each block above high_load raises the shed
+// level by one step, up to max_level. Once the load has stayed below
+// low_load for restore_blocks consecutive blocks, the level drops by one
+// step, so quality returns gradually after the peak has passed.
+class LoadShedder
+{
+public:
+    struct Config
+    {
+        float high_load = 0.85f;
+        float low_load = 0.7f;
+        int restore_blocks = 500;
+        int max_level = 10;
+    };
+
+    LoadShedder() = default;
+
+    explicit LoadShedder(const Config& config) :
+        _config(config)
+    {
+    }
+
+    void update(float load)
+    {
+        _peak_load = std::max(_peak_load, load);
+
+        if (load > _config.high_load)
+        {
+            if (_level == 0)
+            {
+                ++_shed_events;
+            }
+            _level = std::min(_level + 1, _config.max_level);
+            _max_level = std::max(_max_level, _level);
+            _low_blocks = 0;
+        }
+        else if ((_level > 0) && (load < _config.low_load))
+        {
+            if (++_low_blocks >= _config.restore_blocks)
+            {
+                --_level;
+                _low_blocks = 0;
+            }
+        }
+        else
+        {
+            _low_blocks = 0;
+        }
+
+        if (_level > 0)
+        {
+            ++_shed_blocks;
+        }
+    }
+
+    // 0 = full quality
+    int level() const { return _level; }
+
+    // Statistics since construction
+    uint32_t shedEvents() const { return _shed_events; }
+    uint32_t shedBlocks() const { return _shed_blocks; }
+    int maxLevel() const { return _max_level; }
+    float peakLoad() const { return _peak_load; }
+
+private:
+    Config _config;
+    int _level = 0;
+    int _low_blocks = 0;
+
+    uint32_t _shed_events = 0;
+    uint32_t _shed_blocks = 0;
+    int _max_level = 0;
+    float _peak_load = 0;
+};
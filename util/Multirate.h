@@ -5,10 +5,12 @@
 
 #include <q/utility/ring_buffer.hpp>
 
+#include <util/Allpass.h>
+
 constexpr size_t resample_factor = 6;
 
 //=============================================================================
-class Decimator
+class FirDecimator
 {
 public:
     float operator()(std::span<const float, resample_factor> s)
@@ -73,7 +75,7 @@ private:
 
 
 //=============================================================================
-class Interpolator
+class FirInterpolator
 {
 public:
     std::array<float, resample_factor> operator()(float s)
@@ -197,3 +199,113 @@ private:
     cycfi::q::ring_buffer<float> buffer1{bsize1};
     cycfi::q::ring_buffer<float> buffer2{bsize2};
 };
+
+
+// Polyphase IIR resamplers
+//
+// Each stage is a sum of allpass branches running at the low sample rate:
+//
+// H(z) = 1/M * sum(z^-k * A_k(z^M)), k = 0..M-1
+//
+// Half-band (M = 2) coefficients are elliptic designs from "Digital signal
+// processing schemes for efficient interpolation and decimation" by
+// Valenzuela and Constantinides. M = 3 coefficients are minimax designs over
+// the bands that alias onto the pass band. An odd number of branches cannot
+// attenuate the Nyquist frequency by more than 1/M, which is harmless here
+// because the following stage or the pass band rejects that region.
+//
+// Compared to the FIR stages, these use fewer multiplies per sample and have
+// lower delay, at the cost of a nonlinear phase response.
+
+//=============================================================================
+class IirDecimator
+{
+public:
+    float operator()(std::span<const float, resample_factor> s)
+    {
+        const auto a = filter1(s.first<3>());
+        const auto b = filter1(s.last<3>());
+        return 0.5f * (filter2a(b) + filter2b(a));
+    }
+
+private:
+    // Filter 1
+    // 48000 Hz sample rate, decimate by 3
+    // 0-1800 Hz pass band
+    // 14200-17800 Hz stop band (-100 dB), which aliases onto the pass band
+
+    float filter1(std::span<const float, 3> s)
+    {
+        return (1.0f / 3.0f) *
+            (filter1a(s[2]) + filter1b(s[1]) + filter1c(s[0]));
+    }
+
+    AllpassChain<2> filter1a{{0.056335823f, 0.71657098f}};
+    AllpassChain<1> filter1b{{0.15935868f}};
+    AllpassChain<1> filter1c{{0.43689700f}};
+
+    // Filter 2
+    // Half-band filter, decimate by 2
+    // 16000 Hz sample rate
+    // 0-1800 Hz pass band
+    // 6200-8000 Hz stop band (-96 dB)
+
+    AllpassChain<2> filter2a{{0.066111546f, 0.67446379f}};
+    AllpassChain<1> filter2b{{0.27345707f}};
+};
+
+
+//=============================================================================
+class IirInterpolator
+{
+public:
+    std::array<float, resample_factor> operator()(float s)
+    {
+        std::array<float, resample_factor> output;
+
+        const auto a = filter1a(s);
+        output[0] = filter2a(a);
+        output[1] = filter2b(a);
+        output[2] = filter2c(a);
+
+        const auto b = filter1b(s);
+        output[3] = filter2a(b);
+        output[4] = filter2b(b);
+        output[5] = filter2c(b);
+
+        return output;
+    }
+
+private:
+    // Filter 1
+    // Half-band filter, interpolate by 2
+    // 16000 Hz sample rate
+    // 0-3600 Hz pass band
+    // 4400-8000 Hz stop band (-80 dB)
+    // Gain=2 in passband
+
+    AllpassChain<3> filter1a{{0.060297391f, 0.41259072f, 0.77271565f}};
+    AllpassChain<3> filter1b{{0.21597144f, 0.60435863f, 0.92388614f}};
+
+    // Filter 2
+    // Interpolate by 3
+    // 48000 Hz sample rate
+    // 0-3600 Hz pass band
+    // 11600-20400 Hz stop band (-78 dB), where the images of 0-4400 Hz fall
+    // Gain=3 in passband
+
+    AllpassChain<3> filter2a{{0.039417117f, 0.37035623f, 0.97131908f}};
+    AllpassChain<2> filter2b{{0.10266544f, 0.59834998f}};
+    AllpassChain<2> filter2c{{0.79513620f, 0.23571770f}};
+};
+
+
+//=============================================================================
+// Resampler engine used by the firmware, selected at build time
+#if defined(IIR_RESAMPLER)
+using Decimator = IirDecimator;
+using Interpolator = IirInterpolator;
+#else
+using Decimator = FirDecimator;
+using Interpolator = FirInterpolator;
+#endif
@@ -1,72 +1,207 @@
 #pragma once
 
-#include <util/BandShifter.h>
+#include <algorithm>
+#include <atomic>
+#include <utility>
+#include <vector>
 
-#include <gcem.hpp>
+#include <util/BandBank.h>
+#include <util/BandShifter.h>
+#include <util/DftBank.h>
+#include <util/RecursiveBank.h>
 
 //=============================================================================
-class OctaveGenerator
+// The band layout can be changed while audio is running. The control thread
+// calls setLayout() and then prepareLayout() on each loop iteration, which
+// computes the new coefficients a few bands at a time into a second bank.
+// The audio thread calls applyLayout() at the start of each block; once the
+// second bank is complete it is swapped in, and each new band takes over the
+// state of an old band with a nearby center frequency.
+//
+// Bank is the analysis engine, e.g. RecursiveBank or DftBank; see BandBank.
+template <BandBank Bank>
+class BasicOctaveGenerator
 {
 public:
-    OctaveGenerator(float sample_rate)
+    using T = typename Bank::Sample;
+    using Shifter = typename Bank::Shifter;
+
+    BasicOctaveGenerator(float sample_rate, const BandLayout& layout = {}) :
+        _sample_rate(sample_rate)
+    {
+        const auto clamped = clampedLayout(layout);
+        _bank.resize(clamped, sample_rate);
+        _bank.build(clamped, sample_rate, 0, int(_bank.shifters.size()));
+        _active_bands = activeBandCount(0);
+    }
+
+    // Control thread: starts preparing a new band layout. Replaces a
+    // prepared layout that has not been applied yet.
+    void setLayout(const BandLayout& layout)
     {
-        for (int i = 0; i < 80; ++i)
+        // The audio thread may be swapping the prepared bank in right now;
+        // wait for it, after which the old bank is the one to rebuild.
+        auto state = _pending_state.load();
+        while ((state == PendingState::swapping) ||
+               !_pending_state.compare_exchange_weak(
+                   state, PendingState::building))
         {
-            const auto center = centerFreq(i);
-            const auto bw = bandwidth(i);
-            _shifters.emplace_back(center, sample_rate, bw);
+            if (state == PendingState::swapping)
+            {
+                state = _pending_state.load();
+            }
         }
+
+        _pending_layout = clampedLayout(layout);
+        _pending_progress = 0;
     }
 
-    void update(float sample)
+    // Control thread: computes coefficients for up to max_bands bands of the
+    // pending layout. Returns true while a layout is being prepared.
+    bool prepareLayout(int max_bands)
     {
-        _up1 = 0;
-        _down1 = 0;
-        _down2 = 0;
+        if (_pending_state.load() != PendingState::building)
+        {
+            return false;
+        }
 
-        for (auto& shifter : _shifters)
+        if (_pending_progress == 0)
         {
-            shifter.update(sample);
-            _up1 += shifter.up1();
-            _down1 += shifter.down1();
-            _down2 += shifter.down2();
+            _pending.resize(_pending_layout, _sample_rate);
         }
+
+        const auto count = int(_pending.shifters.size());
+        const auto end = std::min(_pending_progress + max_bands, count);
+        _pending.build(_pending_layout, _sample_rate, _pending_progress, end);
+        _pending_progress = end;
+
+        if (_pending_progress == count)
+        {
+            _pending_state.store(PendingState::ready);
+            return false;
+        }
+        return true;
     }
 
-    float up1() const
+    // Audio thread: swaps in a prepared layout. Call at block boundaries.
+    // Costs one state copy per band.
+    void applyLayout()
     {
-        return _up1;
+        auto expected = PendingState::ready;
+        if (!_pending_state.compare_exchange_strong(
+                expected, PendingState::swapping))
+        {
+            return;
+        }
+
+        _pending.carryStateFrom(_bank);
+        std::swap(_bank, _pending);
+        _pending_state.store(PendingState::idle);
+
+        // Shed bands of the new bank are reset when they resume
+        _active_bands = activeBandCount(_shed_bands);
     }
 
-    float down1() const
+    // Selects the voices computed by update(); see the voice namespace.
+    // Disabled voices output zero. Intended to be called at block rate.
+    void setVoices(unsigned voices)
     {
-        return _down1;
+        if (voices & ~_voices & voice::from_down1)
+        {
+            for (auto& shifter : _bank.shifters)
+            {
+                shifter.resync(voices);
+            }
+        }
+        _voices = voices;
     }
 
-    float down2() const
+    // Skips the given number of highest bands in update() to reduce load.
+    // At least one band is kept. Bands that resume start from silence, so
+    // they fade in over the rise time of their filter instead of resuming
+    // with stale state. Intended to be called at block rate.
+    void setShedBands(int count)
     {
-        return _down2;
+        const auto active = activeBandCount(count);
+        for (int i = _active_bands; i < active; ++i)
+        {
+            _bank.shifters[i].reset();
+        }
+        _shed_bands = count;
+        _active_bands = active;
+    }
+
+    void update(T sample)
+    {
+        _mix = _bank.update(sample, _active_bands, _voices);
+    }
+
+    T up1() const
+    {
+        return _mix.up1;
+    }
+
+    T down1() const
+    {
+        return _mix.down1;
+    }
+
+    T down2() const
+    {
+        return _mix.down2;
+    }
+
+    T up2() const
+    {
+        return _mix.up2;
+    }
+
+    T down3() const
+    {
+        return _mix.down3;
+    }
+
+    // Center frequencies of the current layout, ascending
+    const std::vector<float>& centers() const
+    {
+        return _bank.centers;
     }
 
 private:
-    static constexpr float centerFreq(const int n)
+    // Band layouts need at least two bands to define their spacing
+    static BandLayout clampedLayout(BandLayout layout)
     {
-        return 480 * gcem::pow(2.0f, (0.027f * n)) - 420;
+        layout.band_count =
+            std::clamp(layout.band_count, 2, BandLayout::max_band_count);
+        return layout;
     }
 
-    static constexpr float bandwidth(const int n)
+    int activeBandCount(int shed_bands) const
     {
-        const float f0 = centerFreq(n-1);
-        const float f1 = centerFreq(n);
-        const float f2 = centerFreq(n+1);
-        const float a = (f2 - f1);
-        const float b = (f1 - f0);
-        return 2.0f * (a*b) / (a+b);
+        const auto size = int(_bank.shifters.size());
+        return std::clamp(size - shed_bands, 1, size);
     }
 
-    std::vector<BandShifter> _shifters;
+    enum class PendingState { idle, building, ready, swapping };
+
+    float _sample_rate;
+    Bank _bank;
+    unsigned _voices = voice::all;
+    int _shed_bands = 0;
+    int _active_bands = 0;
 
-    float _up1 = 0;
-    float _down1 = 0;
-    float _down2 = 0;
+    // Owned by the control thread while building, by the audio thread while
+    // ready or swapping
+    Bank _pending;
+    BandLayout _pending_layout;
+    int _pending_progress = 0;
+    std::atomic<PendingState> _pending_state{PendingState::idle};
+
+    VoiceMix<T> _mix;
 };
+
+#if defined(DFT_FILTER_BANK)
+using OctaveGenerator = BasicOctaveGenerator<DftBank<float, FastRoots>>;
+#else
+using OctaveGenerator = BasicOctaveGenerator<RecursiveBank<float, FastRoots>>;
+#endif
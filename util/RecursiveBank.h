@@ -0,0 +1,76 @@
+#pragma once
+
+#include <vector>
+
+#include <util/BandBank.h>
+#include <util/BandShifter.h>
+
+//=============================================================================
+// Band bank with an independent complex band-pass filter per band, evaluated
+// by each BandShifter. Costs one filter update per band and sample, and
+// places the bands freely, as the BandLayout curve describes.
+template <typename T, typename Roots>
+struct RecursiveBank
+{
+    using Sample = T;
+    using Shifter = BasicBandShifter<T, Roots>;
+
+    void resize(const BandLayout& layout, float)
+    {
+        shifters.resize(layout.band_count);
+        centers.resize(layout.band_count);
+        bandwidths.resize(layout.band_count);
+    }
+
+    void build(const BandLayout& layout, float sample_rate,
+               int begin, int end)
+    {
+        for (int i = begin; i < end; ++i)
+        {
+            centers[i] = layout.centerFreq(i);
+            bandwidths[i] = layout.bandwidth(i);
+            shifters[i] = Shifter(centers[i], sample_rate, bandwidths[i]);
+        }
+    }
+
+    void carryStateFrom(const RecursiveBank& old)
+    {
+        carryShifterState(*this, old);
+    }
+
+    VoiceMix<T> update(T sample, int band_count, unsigned voices)
+    {
+        VoiceMix<T> mix;
+        for (int i = 0; i < band_count; ++i)
+        {
+            auto& shifter = shifters[i];
+            shifter.update(sample, voices);
+
+            if (voices & voice::up1)
+            {
+                mix.up1 += shifter.up1();
+            }
+            if (voices & voice::down1)
+            {
+                mix.down1 += shifter.down1();
+            }
+            if (voices & voice::down2)
+            {
+                mix.down2 += shifter.down2();
+            }
+            if (voices & voice::up2)
+            {
+                mix.up2 += shifter.up2();
+            }
+            if (voices & voice::down3)
+            {
+                mix.down3 += shifter.down3();
+            }
+        }
+        return mix;
+    }
+
+    std::vector<Shifter> shifters;
+    std::vector<float> centers;
+    std::vector<float> bandwidths;
+};
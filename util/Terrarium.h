@@ -1,39 +1,64 @@
 #pragma once
 
-#include <array>
+#include <cstddef>
+#include <cstdint>
 #include <functional>
 
-#include <daisy_seed.h>
-
-#include <util/Led.h>
-
+// Hardware interface of the Terrarium pedal: audio, knobs, foot switches and
+// LEDs. DaisyTerrarium drives the real hardware. Host builds provide a
+// simulated implementation so the firmware can run on a desktop machine.
 class Terrarium
 {
 public:
-    // Initializes the Daisy Seed hardware and the Terrarium interface.
-    // Call this method before using other members of this class.
-    void Init(bool boost = false);
-
-    // Start an infinite loop that executes at the given frequency in hertz.
-    // Sets the Terrarium knob sample rates to match the loop frequency.
-    // Automatically debounces the Terrarium toggle and stomp switches.
-    void Loop(float frequency, std::function<void()> callback);
-
-    daisy::DaisySeed seed;
+    // Same layout as daisy::AudioHandle: one buffer per channel
+    using InputBuffer = const float* const*;
+    using OutputBuffer = float**;
+    using AudioCallback = void (*)(InputBuffer in, OutputBuffer out,
+                                   size_t size);
 
     static constexpr int knob_count = 6;
     static constexpr int toggle_count = 4;
     static constexpr int stomp_count = 2;
     static constexpr int led_count = 2;
 
-    std::array<daisy::AnalogControl, knob_count> knobs;
-    std::array<daisy::Switch, toggle_count> toggles;
-    std::array<daisy::Switch, stomp_count> stomps;
-    std::array<Led, led_count> leds;
+    virtual ~Terrarium() = default;
+
+    // Initializes the hardware.
+    // Call this method before using other members of this class.
+    virtual void Init(bool boost = false) = 0;
+
+    virtual float AudioSampleRate() = 0;
+    virtual size_t AudioBlockSize() = 0;
+
+    // Starts calling the given function for each block of audio.
+    virtual void StartAudio(AudioCallback callback) = 0;
+
+    // Start a loop that executes at the given frequency in hertz.
+    // Sets the knob sample rates to match the loop frequency.
+    // Automatically debounces the toggle and stomp switches.
+    virtual void Loop(float frequency, std::function<void()> callback) = 0;
+
+    // Updates and returns the filtered position of a knob.
+    // 0.0 = fully counterclockwise
+    // 1.0 = fully clockwise
+    // Call once per loop iteration for each knob in use.
+    virtual float ProcessKnob(int index) = 0;
+
+    // Returns true on the loop iteration in which a stomp switch is pressed.
+    virtual bool StompRisingEdge(int index) = 0;
+
+    // Returns true while a toggle switch is on.
+    virtual bool ToggleOn(int index) = 0;
+
+    // Sets LED brightness.
+    // 0.0 = off
+    // 1.0 = max brightness
+    virtual void SetLed(int index, float brightness) = 0;
+
+    // Free-running counter for measuring processing time. Differences of
+    // two readings are valid across wrap-around.
+    virtual uint32_t TimerTicks() = 0;
 
-private:
-    void InitKnobs();
-    void InitToggles();
-    void InitStomps();
-    void InitLeds();
+    // Rate of TimerTicks() in ticks per second
+    virtual float TimerTickRate() = 0;
 };